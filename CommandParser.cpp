@@ -1,7 +1,6 @@
 #include "CommandParser.h"
 #include "TrainSystem.h"
 #include "DataStructure/List.h"
-#include "DataStructure/RedBlackTree.h"
 
 namespace trainsys {
     extern UserInfo currentUser;
@@ -14,7 +13,6 @@ namespace trainsys {
     extern StationManager *stationManager;
 
     static char *argMap[200];
-    extern RedBlackTree<String, StationID> stationNameToIDMapping;
 
     bool isStringEnding(char ch) {
         return ch == '\0' || ch == '\n' || ch == '\r';
@@ -84,6 +82,26 @@ namespace trainsys {
                 /* Question */
             } else if (strcmp(commandName, "expire_ticket") == 0) {
                 /* Question */
+            } else if (strcmp(commandName, "release_range") == 0) {
+                // -i 车次1|车次2|... -f 起始日期 -t 结束日期
+                Date dateFrom, dateTo;
+                try {
+                    dateFrom = Date(argMap['f']);
+                    dateTo = Date(argMap['t']);
+                } catch (const std::invalid_argument &) {
+                    std::cout << "Invalid date." << std::endl;
+                    exitCode = -1;
+                }
+                if (exitCode != -1) {
+                    seqList<char *> ids = splitTokens(argMap['i'], '|');
+                    TrainID *trainIDs = new TrainID[ids.length()];
+                    for (int i = 0; i < ids.length(); ++i) {
+                        trainIDs[i] = TrainID(ids.visit(i));
+                        delete[] ids.visit(i);
+                    }
+                    releaseTicketRange(trainIDs, ids.length(), dateFrom, dateTo);
+                    delete[] trainIDs;
+                }
             } else if (strcmp(commandName, "display_route") == 0) {
                 /* Question */
             } else if (strcmp(commandName, "query_best_path") == 0) {
@@ -98,6 +116,14 @@ namespace trainsys {
                 /* Question */
             } else if (strcmp(commandName, "query_accessibility") == 0) {
                 /* Question */
+            } else if (strcmp(commandName, "add_station") == 0) {
+                addStation(stringToNumber(argMap['i']), argMap['n']);
+            } else if (strcmp(commandName, "rename_station") == 0) {
+                renameStation(stringToNumber(argMap['i']), argMap['n']);
+            } else if (strcmp(commandName, "remove_station") == 0) {
+                removeStation(stringToNumber(argMap['i']));
+            } else if (strcmp(commandName, "search_station") == 0) {
+                searchStation(argMap['n'], stringToNumber(argMap['k']));
             } else if (strcmp(commandName, "exit") == 0) {
                 exitCode = 1;
             } else {
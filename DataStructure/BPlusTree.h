@@ -3,12 +3,20 @@
 
 #include <vector>
 #include <fstream>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <type_traits>
 #include "Pair.h"
 #include "SearchTable.h"
 #include "List.h"
+#include "DeltaCodec.h"
+#include "FileSync.h"
 
 namespace trainsys {
-    template<class KeyType, class ValueType, int M = 100, int L = 100>
+    // UniqueKey为真时每个键至多一个值（映射模式）：只按键排序和比较，值类型不需要比较运算符，
+    // insert遇到已有的键时覆盖其值，remove(key, value)删除该键的值而不比较value
+    template<class KeyType, class ValueType, int M = 100, int L = 100, bool UniqueKey = false>
     class BPlusTree : public StorageSearchTable<KeyType, ValueType> {
     private:
         std::fstream treeNodeFile, leafFile;
@@ -32,15 +40,44 @@ namespace trainsys {
             Pair<KeyType, ValueType> value[L];
         };
 
-        std::string treeNodeFileName, leafFileName;
+        // 冷叶子压缩模式下，叶子文件不再按pos定长排布，每个叶子在文件中的位置记录在索引文件里
+        // 最近写过的叶子保持原样（length == sizeof(Leaf)，可原地覆盖），压缩整理时冷叶子被编码存放
+        // 索引文件依次为叶子文件的有效长度、写入计数、索引项数、空闲叶子数、各索引项和空闲叶子列表；
+        // 叶子被分配新位置时立即写入对应的索引项，空闲叶子列表只在析构时写出
+        struct LeafExtent {
+            long long offset;
+            int length;
+            int lastWrite;
+        };
+
+        static const int leafIndexHeaderLength = sizeof(long long) + 3 * sizeof(int);
+        static const int LEAF_CACHE_SIZE = 4; // 缓存的已解码冷叶子数，按pos直接映射
+
+        bool compressed;
+        std::fstream leafIndexFile;
+        std::vector<LeafExtent> leafExtents;
+        long long leafHeapEnd;
+        int writeTick;
+        std::vector<char> extentBuffer; // 读压缩叶子时的缓冲区，反复使用
+        std::vector<Leaf> leafCache;
+        std::vector<int> leafCachePos; // leafCache中各叶子的pos，0表示空
+
+        std::string treeNodeFileName, leafFileName, leafIndexFileName;
         TreeNode root;
 
     public:
-        explicit BPlusTree(const std::string &name) {
+        // 默认多少次叶子写入之内没有被写过的叶子算作冷叶子
+        static const int DEFAULT_COLD_WRITE_DISTANCE = 1000;
+
+        explicit BPlusTree(const std::string &name, bool compressColdLeaves = false)
+            : compressed(compressColdLeaves), leafHeapEnd(0), writeTick(0) {
             treeNodeFileName = name + "_treeNodeFile", leafFileName = name + "_leafFile";
+            leafIndexFileName = name + "_leafIndexFile";
+            if (compressed) finishCompaction();
             treeNodeFile.open(treeNodeFileName, std::ios::in | std::ios::out | std::ios::binary);
             leafFile.open(leafFileName, std::ios::in | std::ios::out | std::ios::binary);
             if (!leafFile || !treeNodeFile) {
+                treeNodeFile.close(), leafFile.close();
                 initialize();
             } else {
                 treeNodeFile.seekg(0), leafFile.seekg(0);
@@ -59,6 +96,10 @@ namespace trainsys {
                 }
                 leafFile.read(reinterpret_cast<char *>(&rearLeaf), sizeof(int));
                 leafFile.read(reinterpret_cast<char *>(&sizeData), sizeof(int));
+                if (compressed) {
+                    loadLeafIndex();
+                    return;
+                }
                 leafFile.seekg(headerLengthOfLeafFile + (rearLeaf + 1) * sizeof(Leaf));
                 leafFile.read(reinterpret_cast<char *>(&leafEmptySize), sizeof(int));
                 for (int i = 0; i < leafEmptySize; i++) {
@@ -70,6 +111,7 @@ namespace trainsys {
         }
 
         ~BPlusTree() {
+            if (compressed && worthCompressing()) compressColdLeaves(DEFAULT_COLD_WRITE_DISTANCE);
             treeNodeFile.seekp(0), leafFile.seekp(0);
             treeNodeFile.write(reinterpret_cast<char *>(&root.pos), sizeof(int));
             treeNodeFile.write(reinterpret_cast<char *>(&rearTreeNode), sizeof(int));
@@ -83,11 +125,17 @@ namespace trainsys {
                 int tmp = emptyTreeNode.visit(i);
                 treeNodeFile.write(reinterpret_cast<char *>(&tmp), sizeof(int));
             }
-            leafFile.seekp(headerLengthOfLeafFile + (rearLeaf + 1) * sizeof(Leaf));
-            leafFile.write(reinterpret_cast<char *>(&emptyLeafCount), sizeof(int));
-            for (int i = 0; i < emptyLeaf.length(); i++) {
-                int tmp = emptyLeaf.visit(i);
-                leafFile.write(reinterpret_cast<char *>(&tmp), sizeof(int));
+            if (compressed) {
+                leafIndexFile.seekp(0);
+                writeLeafIndex(leafIndexFile, leafExtents, leafHeapEnd, true);
+                leafIndexFile.close();
+            } else {
+                leafFile.seekp(headerLengthOfLeafFile + (rearLeaf + 1) * sizeof(Leaf));
+                leafFile.write(reinterpret_cast<char *>(&emptyLeafCount), sizeof(int));
+                for (int i = 0; i < emptyLeaf.length(); i++) {
+                    int tmp = emptyLeaf.visit(i);
+                    leafFile.write(reinterpret_cast<char *>(&tmp), sizeof(int));
+                }
             }
             leafFile.close();
             treeNodeFile.close();
@@ -96,6 +144,9 @@ namespace trainsys {
         int size() { return sizeData; }
 
         void insert(const KeyType &key, const ValueType &value) {
+            if constexpr (UniqueKey) {
+                if (updateFirst(key, [&value](ValueType &stored) { stored = value; })) return;
+            }
             if (insert(Pair<KeyType, ValueType>(key, value), root)) {
                 TreeNode newRoot;
                 TreeNode newNode;
@@ -124,36 +175,141 @@ namespace trainsys {
         }
 
         seqList<ValueType> find(const KeyType &key) {
+            return find(key, 0, -1);
+        }
+
+        seqList<ValueType> find(const KeyType &key, int offset, int limit) {
             seqList<ValueType> ans;
+            forEach(key, [&ans](const ValueType &value) { ans.pushBack(value); }, offset, limit);
+            return ans;
+        }
+
+        // 依次将key对应的值以常引用交给visit，引用只在回调期间有效（指向当前读入的叶子页）
+        // visit可返回bool，返回false时提前结束；offset/limit用于分页，limit为-1表示不限
+        // 返回实际交给visit的值的个数
+        template<class Visitor>
+        int forEach(const KeyType &key, Visitor visit, int offset = 0, int limit = -1) {
             TreeNode p = root;
             Leaf leaf;
-            if (p.dataCount == 0) {
-                return ans;
+            int count = 0;
+            if (p.dataCount == 0 || limit == 0) {
+                return count;
             }
             while (!p.isBottomNode) {
                 readTreeNode(p, p.childrenPos[binarySearchTreeNode(key, p)]);
             }
             readLeaf(leaf, p.childrenPos[binarySearchTreeNode(key, p)]);
             int now = binarySearchLeaf(key, leaf);
-            while (now < leaf.dataCount && leaf.value[now].first == key) {
-                ans.pushBack(leaf.value[now++].second);
+            while (true) {
+                while (now < leaf.dataCount && leaf.value[now].first == key) {
+                    if (offset > 0) {
+                        offset--, now++;
+                        continue;
+                    }
+                    count++;
+                    const ValueType &value = leaf.value[now++].second;
+                    if (!visitValue(visit, value) || count == limit) {
+                        return count;
+                    }
+                }
+                if (!leaf.nxt || now != leaf.dataCount) break;
+                readLeaf(leaf, leaf.nxt);
+                now = 0;
+            }
+            return count;
+        }
+
+        // 按键升序把键在[low, high]内的键值对交给visit(key, value)，引用只在回调期间有效
+        // visit可返回bool，返回false时提前结束；返回实际交给visit的键值对个数
+        template<class Visitor>
+        int forEachInRange(const KeyType &low, const KeyType &high, Visitor visit) {
+            TreeNode p = root;
+            Leaf leaf;
+            int count = 0;
+            if (p.dataCount == 0 || high < low) {
+                return count;
+            }
+            while (!p.isBottomNode) {
+                readTreeNode(p, p.childrenPos[binarySearchTreeNode(low, p)]);
             }
-            while (leaf.nxt && now == leaf.dataCount) {
+            readLeaf(leaf, p.childrenPos[binarySearchTreeNode(low, p)]);
+            int now = binarySearchLeaf(low, leaf);
+            while (true) {
+                while (now < leaf.dataCount && !(high < leaf.value[now].first)) {
+                    count++;
+                    const Pair<KeyType, ValueType> &entry = leaf.value[now++];
+                    if (!visitEntry(visit, entry.first, entry.second)) {
+                        return count;
+                    }
+                }
+                if (!leaf.nxt || now != leaf.dataCount) break;
                 readLeaf(leaf, leaf.nxt);
                 now = 0;
-                while (now < leaf.dataCount && leaf.value[now].first == key) {
-                    ans.pushBack(leaf.value[now++].second);
+            }
+            return count;
+        }
+
+        // 按（键，值）升序把所有键值对交给visit(key, value)，用法同forEachInRange
+        template<class Visitor>
+        int forEachEntry(Visitor visit) {
+            TreeNode p = root;
+            Leaf leaf;
+            int count = 0;
+            if (p.dataCount == 0) {
+                return count;
+            }
+            while (!p.isBottomNode) {
+                readTreeNode(p, p.childrenPos[0]);
+            }
+            for (int pos = p.childrenPos[0]; pos; pos = leaf.nxt) {
+                readLeaf(leaf, pos);
+                for (int i = 0; i < leaf.dataCount; i++) {
+                    count++;
+                    if (!visitEntry(visit, leaf.value[i].first, leaf.value[i].second)) {
+                        return count;
+                    }
+                }
+            }
+            return count;
+        }
+
+        // 批量查找升序排列的keys，对每个存在的键调用visit(i, keys[i]的第一个值)
+        // 相邻的键落在同一个叶子时不再从根重新查找，适合一次读入一批键
+        template<class Visitor>
+        void forEachSorted(const KeyType *keys, int n, Visitor visit) {
+            Leaf leaf;
+            bool hasLeaf = false;
+            if (root.dataCount == 0) return;
+            for (int i = 0; i < n; i++) {
+                const KeyType &key = keys[i];
+                if (!hasLeaf || leaf.dataCount == 0 || !(leaf.value[0].first < key) ||
+                    leaf.value[leaf.dataCount - 1].first < key) {
+                    TreeNode p = root;
+                    while (!p.isBottomNode) {
+                        readTreeNode(p, p.childrenPos[binarySearchTreeNode(key, p)]);
+                    }
+                    readLeaf(leaf, p.childrenPos[binarySearchTreeNode(key, p)]);
+                    hasLeaf = true;
+                }
+                int now = binarySearchLeaf(key, leaf);
+                if (now < leaf.dataCount && leaf.value[now].first == key) {
+                    visit(i, leaf.value[now].second);
+                } else if (now == leaf.dataCount && leaf.nxt) {
+                    Leaf next;
+                    readLeaf(next, leaf.nxt);
+                    if (next.dataCount > 0 && next.value[0].first == key) visit(i, next.value[0].second);
                 }
             }
-            return ans;
         }
 
         bool contains(const KeyType &key) {
-            return !find(key).empty();
+            return forEach(key, [](const ValueType &) {}, 0, 1) > 0;
         }
 
         ValueType findFirst(const KeyType &key) {
-            return find(key).visit(0);
+            ValueType ans{};
+            forEach(key, [&ans](const ValueType &value) { ans = value; }, 0, 1);
+            return ans;
         }
 
         void remove(const KeyType &key, const ValueType &value) {
@@ -171,6 +327,33 @@ namespace trainsys {
             remove(key, findFirst(key));
         }
 
+        // 就地修改key对应的第一个值：update收到值的引用，返回true（或无返回值）时写回所在叶子，只写一页
+        // update不能改变该值与同一键下其他值的相对次序，否则B+树的有序性被破坏；找不到key时返回false
+        template<class Updater>
+        bool updateFirst(const KeyType &key, Updater update) {
+            TreeNode p = root;
+            Leaf leaf;
+            if (p.dataCount == 0) {
+                return false;
+            }
+            while (!p.isBottomNode) {
+                readTreeNode(p, p.childrenPos[binarySearchTreeNode(key, p)]);
+            }
+            readLeaf(leaf, p.childrenPos[binarySearchTreeNode(key, p)]);
+            int now = binarySearchLeaf(key, leaf);
+            if (now == leaf.dataCount && leaf.nxt) {
+                readLeaf(leaf, leaf.nxt);
+                now = 0;
+            }
+            if (now == leaf.dataCount || !(leaf.value[now].first == key)) {
+                return false;
+            }
+            if (visitValue(update, leaf.value[now].second)) {
+                writeLeaf(leaf);
+            }
+            return true;
+        }
+
         void modify(const KeyType &key, const ValueType &oldValue, const ValueType &newValue) {
             remove(key, oldValue);
             insert(key, newValue);
@@ -179,12 +362,190 @@ namespace trainsys {
         void clear() {
             treeNodeFile.close();
             leafFile.close();
+            leafIndexFile.close();
             emptyTreeNode.clear();
             emptyLeaf.clear();
             initialize();
         }
 
+        // 用按entryLess升序排列的n个键值对重建整棵树，原有数据被清空
+        // 自底向上逐层写出，叶子和结点除最后一个空位外都尽量填满，每页只写一次
+        void bulkLoad(const Pair<KeyType, ValueType> *entries, int n) {
+            for (int i = 1; i < n; i++) {
+                if (entryLess(entries[i], entries[i - 1])) {
+                    throw std::invalid_argument("bulkLoad: entries are not sorted");
+                }
+                if (UniqueKey && !entryLess(entries[i - 1], entries[i])) {
+                    throw std::invalid_argument("bulkLoad: duplicate key");
+                }
+            }
+            clear();
+            if (n == 0) return;
+            // 当前层各结点的位置及其子树中最大的键值对，即上一层的分隔键
+            std::vector<int> positions;
+            std::vector<Pair<KeyType, ValueType>> maxima;
+            int leafCount = (n + L - 2) / (L - 1);
+            Leaf leaf;
+            for (int i = 0, begin = 0; i < leafCount; i++) {
+                int end = static_cast<long long>(n) * (i + 1) / leafCount;
+                leaf.pos = i + 1;
+                leaf.nxt = i + 1 < leafCount ? i + 2 : 0;
+                leaf.dataCount = end - begin;
+                for (int j = begin; j < end; j++) {
+                    leaf.value[j - begin] = entries[j];
+                }
+                writeLeaf(leaf);
+                positions.push_back(leaf.pos);
+                maxima.push_back(entries[end - 1]);
+                begin = end;
+            }
+            rearLeaf = leafCount, sizeData = n, rearTreeNode = 0;
+            bool isBottomNode = true;
+            do {
+                int childCount = positions.size(), nodeCount = (childCount + M - 2) / (M - 1);
+                std::vector<int> parentPositions;
+                std::vector<Pair<KeyType, ValueType>> parentMaxima;
+                for (int i = 0, begin = 0; i < nodeCount; i++) {
+                    int end = static_cast<long long>(childCount) * (i + 1) / nodeCount;
+                    root.pos = ++rearTreeNode;
+                    root.isBottomNode = isBottomNode;
+                    root.dataCount = end - begin;
+                    for (int j = begin; j < end; j++) {
+                        root.childrenPos[j - begin] = positions[j];
+                        if (j + 1 < end) root.septal[j - begin] = maxima[j];
+                    }
+                    writeTreeNode(root);
+                    parentPositions.push_back(root.pos);
+                    parentMaxima.push_back(maxima[end - 1]);
+                    begin = end;
+                }
+                positions.swap(parentPositions);
+                maxima.swap(parentMaxima);
+                isBottomNode = false;
+            } while (positions.size() > 1);
+        }
+
+        // 树中键值对的次序，bulkLoad要求输入按此升序
+        static bool entryLess(const Pair<KeyType, ValueType> &lhs, const Pair<KeyType, ValueType> &rhs) {
+            if constexpr (UniqueKey) return lhs.first < rhs.first;
+            else return checkPairLess(lhs, rhs);
+        }
+
+        static bool entryEqual(const Pair<KeyType, ValueType> &lhs, const Pair<KeyType, ValueType> &rhs) {
+            if constexpr (UniqueKey) return lhs.first == rhs.first;
+            else return checkPairEqual(lhs, rhs);
+        }
+
+        static bool exists(const std::string &name) {
+            std::ifstream probe(name + "_treeNodeFile", std::ios::in | std::ios::binary);
+            return static_cast<bool>(probe);
+        }
+
+        // 把名为from的B+树的文件逐个改名为to，覆盖名为to的树中的同名文件，两棵树都不能处于打开状态
+        // exists检查的结点文件最后改名，中途崩溃时exists(from)仍为真，再次调用会把剩下的文件改完
+        static void rename(const std::string &from, const std::string &to) {
+            for (const char *suffix : {"_leafFile", "_leafIndexFile", "_treeNodeFile"}) {
+                std::error_code error;
+                if (std::filesystem::exists(from + suffix, error)) std::filesystem::rename(from + suffix, to + suffix);
+            }
+        }
+
+        // 把名为name的B+树的文件刷到磁盘，这棵树不能处于打开状态
+        static void sync(const std::string &name) {
+            syncFile((name + "_treeNodeFile").c_str());
+            syncFile((name + "_leafFile").c_str());
+            syncFile((name + "_leafIndexFile").c_str());
+        }
+
+        // 删除名为name的B+树的所有文件，包括压缩整理留下的临时文件，这棵树不能处于打开状态
+        static void destroy(const std::string &name) {
+            std::remove((name + "_treeNodeFile").c_str());
+            std::remove((name + "_leafFile").c_str());
+            std::remove((name + "_leafIndexFile").c_str());
+            std::remove((name + "_leafFile.tmp").c_str());
+            std::remove((name + "_leafIndexFile.tmp").c_str());
+            std::remove((name + "_leafIndexFile.commit").c_str());
+        }
+
+        // 重写叶子文件：最近coldWriteDistance次叶子写入中没有写过的叶子压缩存放，其余原样存放，
+        // 同时回收已释放叶子和被替换的旧记录占用的空间。只在压缩模式下有效，析构时若值得重写会自动调用
+        // 新的叶子文件和索引都写到临时文件并刷盘，索引改名为提交文件后再依次替换，中途崩溃时重新打开会完成替换
+        void compressColdLeaves(int coldWriteDistance) {
+            if (!compressed) return;
+            std::vector<bool> isEmptyLeaf(leafExtents.size(), false);
+            for (int i = 0; i < emptyLeaf.length(); i++) {
+                isEmptyLeaf[emptyLeaf.visit(i)] = true;
+            }
+            std::string tmpFileName = leafFileName + ".tmp";
+            std::ofstream tmpFile(tmpFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+            tmpFile.write(reinterpret_cast<char *>(&rearLeaf), sizeof(int));
+            tmpFile.write(reinterpret_cast<char *>(&sizeData), sizeof(int));
+            std::vector<char> buffer(deltaEncodeBound(sizeof(Leaf)));
+            std::vector<LeafExtent> extents = leafExtents;
+            long long heapEnd = headerLengthOfLeafFile;
+            Leaf leaf;
+            for (int pos = 0; pos < static_cast<int>(extents.size()); pos++) {
+                LeafExtent &extent = extents[pos];
+                if (extent.length == 0) continue;
+                if (isEmptyLeaf[pos]) {
+                    extent.length = 0;
+                    continue;
+                }
+                readLeaf(leaf, pos);
+                const char *data = reinterpret_cast<char *>(&leaf);
+                int length = sizeof(Leaf);
+                if (writeTick - extent.lastWrite >= coldWriteDistance) {
+                    int encodedLength = encodeLeaf(leaf, buffer.data());
+                    if (encodedLength < length) data = buffer.data(), length = encodedLength;
+                }
+                tmpFile.write(data, length);
+                extent.offset = heapEnd, extent.length = length;
+                heapEnd += length;
+            }
+            tmpFile.close();
+            std::string tmpIndexName = leafIndexFileName + ".tmp", commitName = leafIndexFileName + ".commit";
+            std::ofstream tmpIndex(tmpIndexName, std::ios::out | std::ios::binary | std::ios::trunc);
+            writeLeafIndex(tmpIndex, extents, heapEnd, false);
+            tmpIndex.close();
+            if (!tmpFile || !tmpIndex || !syncFile(tmpFileName.c_str()) || !syncFile(tmpIndexName.c_str())) {
+                std::remove(tmpFileName.c_str());
+                std::remove(tmpIndexName.c_str());
+                throw std::runtime_error("BPlusTree: failed to write " + tmpFileName);
+            }
+            std::filesystem::rename(tmpIndexName, commitName);
+            syncDirectoryOf(leafFileName);
+            leafFile.close();
+            leafIndexFile.close();
+            std::filesystem::rename(tmpFileName, leafFileName);
+            std::filesystem::rename(commitName, leafIndexFileName);
+            syncDirectoryOf(leafFileName);
+            leafFile.open(leafFileName, std::ios::in | std::ios::out | std::ios::binary);
+            leafIndexFile.open(leafIndexFileName, std::ios::in | std::ios::out | std::ios::binary);
+            leafExtents.swap(extents);
+            leafHeapEnd = heapEnd;
+        }
+
     private:
+        template<class Visitor, class Value>
+        static bool visitValue(Visitor &visit, Value &value) {
+            if constexpr (std::is_void<decltype(visit(value))>::value) {
+                visit(value);
+                return true;
+            } else {
+                return visit(value);
+            }
+        }
+
+        template<class Visitor>
+        static bool visitEntry(Visitor &visit, const KeyType &key, const ValueType &value) {
+            if constexpr (std::is_void<decltype(visit(key, value))>::value) {
+                visit(key, value);
+                return true;
+            } else {
+                return visit(key, value);
+            }
+        }
+
         bool insert(const Pair<KeyType, ValueType> &val, TreeNode &currentNode) {
             if (currentNode.isBottomNode) {
                 Leaf leaf;
@@ -263,7 +624,7 @@ namespace trainsys {
                 int nodePos = binarySearchTreeNodeValue(val, currentNode);
                 readLeaf(leaf, currentNode.childrenPos[nodePos]);
                 int leafPos = binarySearchLeafValue(val, leaf);
-                if (leafPos == leaf.dataCount || !checkPairEqual(leaf.value[leafPos], val)) {
+                if (leafPos == leaf.dataCount || !entryEqual(leaf.value[leafPos], val)) {
                     return false;
                 }
                 leaf.dataCount--, sizeData--;
@@ -449,6 +810,10 @@ namespace trainsys {
         }
 
         void writeLeaf(Leaf &leaf) {
+            if (compressed) {
+                writeLeafExtent(leaf);
+                return;
+            }
             leafFile.seekg(leaf.pos * sizeof(Leaf) + headerLengthOfLeafFile);
             leafFile.write(reinterpret_cast<char *>(&leaf), sizeof(Leaf));
         }
@@ -459,25 +824,217 @@ namespace trainsys {
         }
 
         void readLeaf(Leaf &lef, int pos) {
+            if (compressed) {
+                readLeafExtent(lef, pos);
+                return;
+            }
             leafFile.seekg(pos * sizeof(Leaf) + headerLengthOfLeafFile);
             leafFile.read(reinterpret_cast<char *>(&lef), sizeof(Leaf));
         }
 
+        // 被写的叶子一律以原样记录存放；若原来是压缩记录，则在文件末尾为它分配原样记录的空间，
+        // 旧的压缩记录留到下次压缩整理时回收
+        // 新分配的位置在叶子写入之后写入索引：进程中途退出时，索引要么仍指向完整的旧记录，要么指向新记录
+        void writeLeafExtent(Leaf &leaf) {
+            if (leaf.pos >= static_cast<int>(leafExtents.size())) {
+                leafExtents.resize(leaf.pos + 1, LeafExtent{0, 0, 0});
+            }
+            LeafExtent &extent = leafExtents[leaf.pos];
+            bool moved = extent.length != static_cast<int>(sizeof(Leaf));
+            if (moved) {
+                extent.offset = leafHeapEnd;
+                extent.length = sizeof(Leaf);
+                leafHeapEnd += sizeof(Leaf);
+            }
+            extent.lastWrite = ++writeTick;
+            leafFile.seekp(extent.offset);
+            leafFile.write(reinterpret_cast<char *>(&leaf), sizeof(Leaf));
+            if (moved) {
+                leafFile.flush();
+                leafIndexFile.seekp(leafIndexHeaderLength + static_cast<long long>(leaf.pos) * sizeof(LeafExtent));
+                leafIndexFile.write(reinterpret_cast<char *>(&extent), sizeof(LeafExtent));
+                writeLeafIndexHeader(0);
+                leafIndexFile.flush();
+            }
+            int slot = leaf.pos % LEAF_CACHE_SIZE;
+            if (!leafCachePos.empty() && leafCachePos[slot] == leaf.pos) leafCachePos[slot] = 0;
+        }
+
+        // 压缩的叶子解码后留在缓存中，反复读取同一个冷叶子时不必再读文件和解码
+        void readLeafExtent(Leaf &lef, int pos) {
+            const LeafExtent &extent = leafExtents[pos];
+            if (extent.length == static_cast<int>(sizeof(Leaf))) {
+                leafFile.seekg(extent.offset);
+                leafFile.read(reinterpret_cast<char *>(&lef), sizeof(Leaf));
+                return;
+            }
+            if (leafCachePos.empty()) {
+                leafCache.resize(LEAF_CACHE_SIZE);
+                leafCachePos.assign(LEAF_CACHE_SIZE, 0);
+            }
+            int slot = pos % LEAF_CACHE_SIZE;
+            if (leafCachePos[slot] != pos) {
+                if (static_cast<int>(extentBuffer.size()) < extent.length) extentBuffer.resize(extent.length);
+                leafFile.seekg(extent.offset);
+                leafFile.read(extentBuffer.data(), extent.length);
+                deltaDecode(extentBuffer.data(), extent.length, leafHeaderLength(), sizeof(Pair<KeyType, ValueType>),
+                            reinterpret_cast<char *>(&leafCache[slot]));
+                leafCachePos[slot] = pos;
+            }
+            lef = leafCache[slot];
+        }
+
+        // 把叶子索引写到out的当前位置；withEmptyLeaves为假时空闲叶子数记为0，运行期间的索引文件都是这样
+        void writeLeafIndex(std::ostream &out, std::vector<LeafExtent> &extents, long long heapEnd,
+                            bool withEmptyLeaves) {
+            int extentCount = extents.size(), emptyLeafCount = withEmptyLeaves ? emptyLeaf.length() : 0;
+            out.write(reinterpret_cast<char *>(&heapEnd), sizeof(long long));
+            out.write(reinterpret_cast<char *>(&writeTick), sizeof(int));
+            out.write(reinterpret_cast<char *>(&extentCount), sizeof(int));
+            out.write(reinterpret_cast<char *>(&emptyLeafCount), sizeof(int));
+            out.write(reinterpret_cast<char *>(extents.data()), extentCount * sizeof(LeafExtent));
+            for (int i = 0; i < emptyLeafCount; i++) {
+                int tmp = emptyLeaf.visit(i);
+                out.write(reinterpret_cast<char *>(&tmp), sizeof(int));
+            }
+        }
+
+        void writeLeafIndexHeader(int emptyLeafCount) {
+            int extentCount = leafExtents.size();
+            leafIndexFile.seekp(0);
+            leafIndexFile.write(reinterpret_cast<char *>(&leafHeapEnd), sizeof(long long));
+            leafIndexFile.write(reinterpret_cast<char *>(&writeTick), sizeof(int));
+            leafIndexFile.write(reinterpret_cast<char *>(&extentCount), sizeof(int));
+            leafIndexFile.write(reinterpret_cast<char *>(&emptyLeafCount), sizeof(int));
+        }
+
+        // 新建索引文件并写入当前的叶子索引
+        void createLeafIndex() {
+            leafIndexFile.close();
+            leafIndexFile.open(leafIndexFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+            writeLeafIndex(leafIndexFile, leafExtents, leafHeapEnd, false);
+            leafIndexFile.close();
+            leafIndexFile.open(leafIndexFileName, std::ios::in | std::ios::out | std::ios::binary);
+        }
+
+        // 读入叶子索引。空闲叶子列表读入后把文件中的空闲叶子数改为0：运行期间追加的索引项会覆盖旧列表，
+        // 中途退出时只会漏记一些空闲叶子。索引文件不存在时按rebuildLeafIndex处理
+        void loadLeafIndex() {
+            leafIndexFile.open(leafIndexFileName, std::ios::in | std::ios::out | std::ios::binary);
+            if (!leafIndexFile) {
+                rebuildLeafIndex();
+                return;
+            }
+            int extentCount = -1, emptyLeafCount = -1;
+            leafIndexFile.read(reinterpret_cast<char *>(&leafHeapEnd), sizeof(long long));
+            leafIndexFile.read(reinterpret_cast<char *>(&writeTick), sizeof(int));
+            leafIndexFile.read(reinterpret_cast<char *>(&extentCount), sizeof(int));
+            leafIndexFile.read(reinterpret_cast<char *>(&emptyLeafCount), sizeof(int));
+            if (!leafIndexFile || extentCount < 0 || emptyLeafCount < 0) {
+                throw std::runtime_error("BPlusTree: corrupted leaf index " + leafIndexFileName);
+            }
+            leafExtents.resize(extentCount);
+            leafIndexFile.read(reinterpret_cast<char *>(leafExtents.data()), extentCount * sizeof(LeafExtent));
+            for (int i = 0; i < emptyLeafCount; i++) {
+                int data;
+                leafIndexFile.read(reinterpret_cast<char *>(&data), sizeof(int));
+                emptyLeaf.pushBack(data);
+            }
+            if (!leafIndexFile) {
+                throw std::runtime_error("BPlusTree: corrupted leaf index " + leafIndexFileName);
+            }
+            // 叶子文件头只在析构时写出，中途退出后rearLeaf可能落后于索引
+            if (rearLeaf < extentCount - 1) rearLeaf = extentCount - 1;
+            writeLeafIndexHeader(0);
+            leafIndexFile.flush();
+        }
+
+        // 没有索引文件时，叶子文件只可能是以非压缩模式建立的定长排布：第pos个叶子在pos * sizeof(Leaf)处，
+        // 其后是空闲叶子列表。据此建立索引；文件长度对不上说明压缩模式的索引丢失，无法恢复，抛出异常而不是清空
+        void rebuildLeafIndex() {
+            long long heapEnd = headerLengthOfLeafFile + (rearLeaf + 1LL) * sizeof(Leaf);
+            int emptyLeafCount = -1;
+            leafFile.seekg(heapEnd);
+            leafFile.read(reinterpret_cast<char *>(&emptyLeafCount), sizeof(int));
+            std::error_code error;
+            long long fileSize = std::filesystem::file_size(leafFileName, error);
+            if (!leafFile || rearLeaf < 1 || emptyLeafCount < 0 ||
+                fileSize != heapEnd + (1LL + emptyLeafCount) * sizeof(int)) {
+                throw std::runtime_error("BPlusTree: missing leaf index " + leafIndexFileName);
+            }
+            for (int i = 0; i < emptyLeafCount; i++) {
+                int data;
+                leafFile.read(reinterpret_cast<char *>(&data), sizeof(int));
+                emptyLeaf.pushBack(data);
+            }
+            leafExtents.assign(rearLeaf + 1, LeafExtent{0, 0, 0});
+            for (int pos = 1; pos <= rearLeaf; pos++) {
+                leafExtents[pos] = LeafExtent{headerLengthOfLeafFile + static_cast<long long>(pos) * sizeof(Leaf),
+                                              static_cast<int>(sizeof(Leaf)), 0};
+            }
+            leafHeapEnd = heapEnd;
+            writeTick = 0;
+            createLeafIndex();
+        }
+
+        // 完成上次中途退出的压缩整理：提交文件存在说明新的叶子文件和索引都已完整写出，把剩下的改名做完；
+        // 否则临时文件都作废
+        void finishCompaction() {
+            std::string tmpFileName = leafFileName + ".tmp", commitName = leafIndexFileName + ".commit";
+            std::error_code error;
+            if (std::filesystem::exists(commitName, error)) {
+                if (std::filesystem::exists(tmpFileName, error)) std::filesystem::rename(tmpFileName, leafFileName);
+                std::filesystem::rename(commitName, leafIndexFileName);
+                syncDirectoryOf(leafFileName);
+            }
+            std::filesystem::remove(tmpFileName, error);
+            std::filesystem::remove(leafIndexFileName + ".tmp", error);
+        }
+
+        // 被替换的旧记录、已释放的叶子和尚未压缩的冷叶子合计超过叶子数据的一半时才值得重写叶子文件，
+        // 冷数据为主、只新写了少量叶子的树关闭时不必重写整个文件
+        bool worthCompressing() const {
+            long long total = leafHeapEnd - headerLengthOfLeafFile, reclaimable = total;
+            std::vector<bool> isEmptyLeaf(leafExtents.size(), false);
+            for (int i = 0; i < emptyLeaf.length(); i++) {
+                isEmptyLeaf[emptyLeaf.visit(i)] = true;
+            }
+            for (int pos = 0; pos < static_cast<int>(leafExtents.size()); pos++) {
+                const LeafExtent &extent = leafExtents[pos];
+                if (extent.length == 0 || isEmptyLeaf[pos]) continue;
+                bool coldRaw = extent.length == static_cast<int>(sizeof(Leaf)) &&
+                               writeTick - extent.lastWrite >= DEFAULT_COLD_WRITE_DISTANCE;
+                if (!coldRaw) reclaimable -= extent.length;
+            }
+            return reclaimable * 2 > total;
+        }
+
+        // 只编码叶子头和有效的dataCount条记录，相邻记录按字节差分
+        int encodeLeaf(const Leaf &leaf, char *dst) {
+            int length = leafHeaderLength() + leaf.dataCount * sizeof(Pair<KeyType, ValueType>);
+            return deltaEncode(reinterpret_cast<const char *>(&leaf), length, leafHeaderLength(),
+                               sizeof(Pair<KeyType, ValueType>), dst);
+        }
+
+        static int leafHeaderLength() {
+            return sizeof(Leaf) - L * sizeof(Pair<KeyType, ValueType>);
+        }
+
         int binarySearchLeafValue(const Pair<KeyType, ValueType> &val, const Leaf &lef) {
             int l = 0, r = lef.dataCount - 1, ans = lef.dataCount;
             while (l <= r) {
                 int mid = (l + r) / 2;
-                if (checkPairLess(lef.value[mid], val)) l = mid + 1;
+                if (entryLess(lef.value[mid], val)) l = mid + 1;
                 else r = mid - 1, ans = mid;
             }
             return ans;
         }
 
         int binarySearchTreeNodeValue(const Pair<KeyType, ValueType> &val, const TreeNode &node) {
-            int l = -1, r = node.dataCount - 2, ans = node.dataCount - 1;
+            int l = 0, r = node.dataCount - 2, ans = node.dataCount - 1;
             while (l <= r) {
                 int mid = (l + r) / 2;
-                if (checkPairLess(node.septal[mid], val)) l = mid + 1;
+                if (entryLess(node.septal[mid], val)) l = mid + 1;
                 else r = mid - 1, ans = mid;
             }
             return ans;
@@ -511,6 +1068,11 @@ namespace trainsys {
             rearTreeNode = 1;
             rearLeaf = 1;
             sizeData = 0;
+            leafExtents.clear();
+            leafHeapEnd = headerLengthOfLeafFile;
+            writeTick = 0;
+            leafCachePos.assign(leafCachePos.size(), 0);
+            if (compressed) createLeafIndex();
 
             treeNodeFile.write(reinterpret_cast<char*>(&rootPos), sizeof(int));
             treeNodeFile.write(reinterpret_cast<char*>(&rearTreeNode), sizeof(int));
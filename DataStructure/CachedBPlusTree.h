@@ -1,41 +1,402 @@
 #ifndef CACHED_BPLUS_TREE_H_
 #define CACHED_BPLUS_TREE_H_
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include "SearchTable.h"
 #include "BPlusTree.h"
 #include "RedBlackTree.h"
+#include "HashTable.h"
+#include "PoolAllocator.h"
 
 namespace trainsys {
-    template<class KeyType, class ValueType>
+    // 带容量上限的LRU缓存，缓存项按最近访问顺序串成双向链表，另用索引表按键找到缓存项
+    // 查找未命中时从B+树读入并放进缓存，超出容量时淘汰最久未访问的项
+    // IndexTable为缓存项的索引结构，只做按键的点查询时可用HashTable代替默认的红黑树
+    // 默认写穿透；开启写回后修改只标记缓存项为脏，同一键的多次修改合并为一次，
+    // 脏项个数超过阈值、脏项被淘汰以及析构时按键排序后批量写回B+树；
+    // 最早的未写回修改超过时间阈值时由后台线程写回，之后没有新的修改也不会一直留在内存中
+    // 确认不存在的键作为否定项记在另一条容量更小的LRU链表中，再次查询时不必访问B+树，插入该键时失效
+    // 析构时把缓存中的键及其访问次数存入filename_hotKeys，下次构造时由后台线程按键排序后批量预读，
+    // 预读或定时写回的线程运行期间各操作与后台线程互斥，没有后台线程时不加锁
+    template<class KeyType, class ValueType, template<class, class> class IndexTable = RedBlackTree>
     class CachedBPlusTree {
     private:
+        struct CacheEntry {
+            KeyType key;
+            ValueType value;
+            CacheEntry *prev, *next;
+            bool dirty;   // 有尚未写回B+树的修改
+            bool removed; // 键已被删除，删除尚未写回时留在缓存中作为墓碑
+            bool stored;  // B+树中可能存有该键的旧记录，写回时需要先删除
+            bool negative; // 否定项：该键确定不存在
+            int hits;      // 访问次数，随热键一起保存
+        };
+
         BPlusTree<KeyType, ValueType> storage;
-        RedBlackTree<KeyType, ValueType> cache;
+        IndexTable<KeyType, CacheEntry *> cache;
+        PoolAllocator<CacheEntry> entryAllocator;
+        CacheEntry head; // 哨兵，head.next为最近访问的项，head.prev为最久未访问的项
+        CacheEntry negativeHead; // 否定项链表的哨兵
+        int capacity, cacheSize;
+        int negativeCapacity, negativeSize;
+        long long hitCount, missCount, evictionCount, negativeHitCount;
+        bool writeBack;
+        int dirtyCount, maxDirtyCount, maxDirtyMillis;
+        std::chrono::steady_clock::time_point firstDirtyTime;
+        std::string hotKeyFileName;
+        mutable std::mutex backgroundLock;
+        std::atomic<bool> warming;
+        std::thread warmUpThread;
+        std::atomic<bool> flusherRunning;
+        bool flusherStopping; // 由backgroundLock保护
+        std::condition_variable flushSignal;
+        std::thread flushThread;
+
+        // 后台线程运行时持有backgroundLock，没有后台线程时不加锁
+        class BackgroundGuard {
+        private:
+            std::unique_lock<std::mutex> lock;
+
+        public:
+            explicit BackgroundGuard(const CachedBPlusTree &tree) {
+                if (tree.warming.load(std::memory_order_acquire) || tree.flusherRunning.load(std::memory_order_acquire)) {
+                    lock = std::unique_lock<std::mutex>(tree.backgroundLock);
+                }
+            }
+        };
 
     public:
-        CachedBPlusTree(const char *filename): storage(filename), cache() {
+        static const int DEFAULT_CAPACITY = 1024;
+
+        CachedBPlusTree(const char *filename, int capacity = DEFAULT_CAPACITY, int negativeCapacity = DEFAULT_CAPACITY / 4)
+            : storage(filename), cache(), capacity(capacity > 0 ? capacity : 1), cacheSize(0),
+              negativeCapacity(negativeCapacity > 0 ? negativeCapacity : 0), negativeSize(0),
+              hitCount(0), missCount(0), evictionCount(0), negativeHitCount(0),
+              writeBack(false), dirtyCount(0), maxDirtyCount(0), maxDirtyMillis(0),
+              hotKeyFileName(std::string(filename) + "_hotKeys"), warming(false), flusherRunning(false),
+              flusherStopping(false) {
+            head.prev = head.next = &head;
+            negativeHead.prev = negativeHead.next = &negativeHead;
+            startWarmUp();
         }
 
-        ~CachedBPlusTree() = default;
+        ~CachedBPlusTree() {
+            if (warmUpThread.joinable()) warmUpThread.join();
+            stopFlusher();
+            flush();
+            saveHotKeys();
+            while (head.next != &head) erase(head.next);
+            while (negativeHead.next != &negativeHead) erase(negativeHead.next);
+        }
 
         bool contains(const KeyType &x) {
-            if (cache.find(x) != nullptr) return true;
-            return storage.contains(x);
+            BackgroundGuard guard(*this);
+            return lookup(x) != nullptr;
         }
 
         ValueType find(const KeyType &x) {
-            if (cache.find(x) != nullptr) return cache.find(x)->value;
-            return storage.findFirst(x);
+            BackgroundGuard guard(*this);
+            CacheEntry *entry = lookup(x);
+            return entry != nullptr ? entry->value : ValueType{};
         }
 
         void insert(const KeyType &key, const ValueType &value) {
-            storage.insert(key, value);
-            cache.insert(DataType<KeyType, ValueType>(key, value));
+            BackgroundGuard guard(*this);
+            DataType<KeyType, CacheEntry *> *found = cache.find(key);
+            bool knownAbsent = false;
+            if (found != nullptr && found->value->negative) {
+                erase(found->value);
+                found = nullptr;
+                knownAbsent = true;
+            }
+            CacheEntry *entry;
+            if (found != nullptr) {
+                entry = found->value;
+                entry->value = value;
+                entry->removed = false;
+                touch(entry);
+            } else {
+                // 否定项说明B+树中没有该键；否则未读过B+树，只能当作可能存在，写回时先删除
+                entry = admit(key, value, !writeBack || !knownAbsent);
+            }
+            if (!writeBack) {
+                storage.insert(key, value);
+                return;
+            }
+            markDirty(entry);
+            flushIfNeeded();
         }
 
         void remove(const KeyType &x) {
-            storage.removeFirst(x);
-            cache.remove(x);
+            BackgroundGuard guard(*this);
+            DataType<KeyType, CacheEntry *> *found = cache.find(x);
+            if (found != nullptr && found->value->negative) return;
+            if (!writeBack) {
+                storage.removeFirst(x);
+                if (found != nullptr) makeNegative(found->value);
+                else admitNegative(x);
+                return;
+            }
+            CacheEntry *entry = found != nullptr ? found->value : admit(x, ValueType{}, true);
+            entry->removed = true;
+            markDirty(entry);
+            flushIfNeeded();
+        }
+
+        // 开启或关闭写回；脏项达到maxDirty个或最早的未写回修改超过maxDelayMillis毫秒时整体写回
+        // maxDelayMillis > 0时启动后台线程按时写回，不依赖后续的修改来触发
+        void setWriteBack(bool enabled, int maxDirty = DEFAULT_CAPACITY / 4, int maxDelayMillis = 1000) {
+            stopFlusher();
+            {
+                BackgroundGuard guard(*this);
+                if (!enabled) flushDirty();
+                writeBack = enabled;
+                maxDirtyCount = maxDirty, maxDirtyMillis = maxDelayMillis;
+            }
+            if (enabled && maxDelayMillis > 0) {
+                flusherRunning.store(true, std::memory_order_release);
+                flushThread = std::thread([this]() { flushLoop(); });
+            }
+        }
+
+        // 把所有脏项按键排序后写回B+树，已删除的项随之转为否定项
+        void flush() {
+            BackgroundGuard guard(*this);
+            flushDirty();
+        }
+
+        int getCapacity() const { return capacity; }
+        int getCacheSize() const { BackgroundGuard guard(*this); return cacheSize; }
+        long long getHitCount() const { BackgroundGuard guard(*this); return hitCount; }
+        long long getMissCount() const { BackgroundGuard guard(*this); return missCount; }
+        long long getEvictionCount() const { BackgroundGuard guard(*this); return evictionCount; }
+        int getDirtyCount() const { BackgroundGuard guard(*this); return dirtyCount; }
+        int getNegativeSize() const { BackgroundGuard guard(*this); return negativeSize; }
+        long long getNegativeHitCount() const { BackgroundGuard guard(*this); return negativeHitCount; }
+        bool isWarmingUp() const { return warming.load(std::memory_order_acquire); }
+
+        // 等待启动时的预读完成
+        void waitForWarmUp() {
+            if (warmUpThread.joinable()) warmUpThread.join();
+        }
+
+    private:
+        // 命中时移到链表头；未命中时查B+树，找到则放入缓存，否则记为否定项，返回nullptr表示不存在
+        CacheEntry *lookup(const KeyType &x) {
+            DataType<KeyType, CacheEntry *> *found = cache.find(x);
+            if (found != nullptr) {
+                CacheEntry *entry = found->value;
+                hitCount++;
+                entry->hits++;
+                touch(entry);
+                if (entry->negative) negativeHitCount++;
+                return entry->removed || entry->negative ? nullptr : entry;
+            }
+            missCount++;
+            CacheEntry *entry = nullptr;
+            storage.forEach(x, [&](const ValueType &value) { entry = admit(x, value, true); }, 0, 1);
+            if (entry == nullptr) admitNegative(x);
+            return entry;
+        }
+
+        CacheEntry *admit(const KeyType &key, const ValueType &value, bool stored) {
+            if (cacheSize == capacity) {
+                CacheEntry *victim = head.prev;
+                if (victim->dirty) writeBackEntry(victim);
+                erase(victim);
+                evictionCount++;
+            }
+            CacheEntry *entry = new (entryAllocator.allocate()) CacheEntry{key, value, nullptr, nullptr, false, false, stored, false, 1};
+            cache.insert(DataType<KeyType, CacheEntry *>(key, entry));
+            pushFront(entry);
+            cacheSize++;
+            return entry;
+        }
+
+        void admitNegative(const KeyType &key) {
+            if (negativeCapacity == 0) return;
+            if (negativeSize == negativeCapacity) erase(negativeHead.prev);
+            CacheEntry *entry = new (entryAllocator.allocate()) CacheEntry{key, ValueType{}, nullptr, nullptr, false, false, false, true, 1};
+            cache.insert(DataType<KeyType, CacheEntry *>(key, entry));
+            pushFront(entry);
+            negativeSize++;
+        }
+
+        // 把已确定不存在的缓存项移到否定项链表，该项必须已写回
+        void makeNegative(CacheEntry *entry) {
+            if (negativeCapacity == 0) {
+                erase(entry);
+                return;
+            }
+            unlink(entry);
+            cacheSize--;
+            if (negativeSize == negativeCapacity) erase(negativeHead.prev);
+            entry->negative = true;
+            entry->removed = entry->stored = false;
+            pushFront(entry);
+            negativeSize++;
+        }
+
+        void erase(CacheEntry *entry) {
+            if (entry->dirty) dirtyCount--;
+            cache.remove(entry->key);
+            unlink(entry);
+            if (entry->negative) negativeSize--;
+            else cacheSize--;
+            entry->~CacheEntry();
+            entryAllocator.deallocate(entry);
+        }
+
+        void markDirty(CacheEntry *entry) {
+            if (entry->dirty) return;
+            if (dirtyCount == 0) firstDirtyTime = std::chrono::steady_clock::now();
+            entry->dirty = true;
+            dirtyCount++;
+        }
+
+        void flushDirty() {
+            if (dirtyCount == 0) return;
+
+            std::vector<CacheEntry *> dirtyEntries;
+            for (CacheEntry *entry = head.next; entry != &head; entry = entry->next) {
+                if (entry->dirty) dirtyEntries.push_back(entry);
+            }
+            std::sort(dirtyEntries.begin(), dirtyEntries.end(),
+                      [](const CacheEntry *lhs, const CacheEntry *rhs) { return lhs->key < rhs->key; });
+            for (CacheEntry *entry : dirtyEntries) {
+                writeBackEntry(entry);
+                if (entry->removed) makeNegative(entry);
+            }
+        }
+
+        void flushIfNeeded() {
+            if (dirtyCount >= maxDirtyCount ||
+                std::chrono::steady_clock::now() - firstDirtyTime >= std::chrono::milliseconds(maxDirtyMillis)) {
+                flushDirty();
+            }
+        }
+
+        // 后台写回线程：有脏项时等到最早的修改满maxDirtyMillis毫秒后写回，没有脏项时每隔maxDirtyMillis毫秒检查一次
+        void flushLoop() {
+            std::unique_lock<std::mutex> lock(backgroundLock);
+            while (!flusherStopping) {
+                std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now();
+                if (dirtyCount > 0) deadline = firstDirtyTime;
+                deadline += std::chrono::milliseconds(maxDirtyMillis);
+                flushSignal.wait_until(lock, deadline, [this, deadline]() {
+                    return flusherStopping || std::chrono::steady_clock::now() >= deadline;
+                });
+                if (!flusherStopping && dirtyCount > 0 &&
+                    std::chrono::steady_clock::now() - firstDirtyTime >= std::chrono::milliseconds(maxDirtyMillis)) {
+                    flushDirty();
+                }
+            }
+        }
+
+        void stopFlusher() {
+            if (!flushThread.joinable()) return;
+            {
+                std::lock_guard<std::mutex> guard(backgroundLock);
+                flusherStopping = true;
+            }
+            flushSignal.notify_all();
+            flushThread.join();
+            flusherStopping = false;
+            flusherRunning.store(false, std::memory_order_release);
+        }
+
+        // 按最近访问顺序保存缓存中存在的键及其访问次数
+        void saveHotKeys() {
+            std::ofstream file(hotKeyFileName, std::ios::out | std::ios::binary);
+            int count = 0;
+            file.write(reinterpret_cast<char *>(&count), sizeof(int));
+            for (CacheEntry *entry = head.next; entry != &head; entry = entry->next) {
+                if (entry->removed) continue;
+                file.write(reinterpret_cast<const char *>(&entry->key), sizeof(KeyType));
+                file.write(reinterpret_cast<const char *>(&entry->hits), sizeof(int));
+                count++;
+            }
+            file.seekp(0);
+            file.write(reinterpret_cast<char *>(&count), sizeof(int));
+        }
+
+        void startWarmUp() {
+            std::ifstream file(hotKeyFileName, std::ios::in | std::ios::binary);
+            int count = 0;
+            if (!file || !file.read(reinterpret_cast<char *>(&count), sizeof(int)) || count <= 0) return;
+            std::vector<Pair<KeyType, int> > hotKeys;
+            for (int i = 0; i < count && i < capacity; i++) {
+                Pair<KeyType, int> hotKey;
+                file.read(reinterpret_cast<char *>(&hotKey.first), sizeof(KeyType));
+                file.read(reinterpret_cast<char *>(&hotKey.second), sizeof(int));
+                if (!file) break;
+                hotKeys.push_back(hotKey);
+            }
+            warming.store(true, std::memory_order_release);
+            warmUpThread = std::thread([this, hotKeys]() mutable { warmUp(hotKeys); });
+        }
+
+        // 热键按键排序后分批在B+树中顺序查找，每批持锁一次，已被前台操作放入缓存的键不再覆盖；
+        // 预读的项接在LRU链表尾部，缓存已满时停止，不挤出前台访问过的项
+        void warmUp(std::vector<Pair<KeyType, int> > &hotKeys) {
+            const int BATCH_SIZE = 64;
+            std::sort(hotKeys.begin(), hotKeys.end(),
+                      [](const Pair<KeyType, int> &lhs, const Pair<KeyType, int> &rhs) { return lhs.first < rhs.first; });
+            std::vector<KeyType> keys;
+            for (const Pair<KeyType, int> &hotKey : hotKeys) keys.push_back(hotKey.first);
+            bool full = false;
+            for (int begin = 0; begin < static_cast<int>(keys.size()) && !full; begin += BATCH_SIZE) {
+                std::lock_guard<std::mutex> guard(backgroundLock);
+                int n = std::min(BATCH_SIZE, static_cast<int>(keys.size()) - begin);
+                storage.forEachSorted(keys.data() + begin, n, [&](int i, const ValueType &value) {
+                    if (cacheSize >= capacity) {
+                        full = true;
+                        return;
+                    }
+                    const KeyType &key = keys[begin + i];
+                    if (cache.find(key) != nullptr) return;
+                    CacheEntry *entry = new (entryAllocator.allocate()) CacheEntry{key, value, nullptr, nullptr, false, false, true, false,
+                                                       hotKeys[begin + i].second};
+                    cache.insert(DataType<KeyType, CacheEntry *>(key, entry));
+                    entry->next = &head, entry->prev = head.prev;
+                    head.prev->next = entry, head.prev = entry;
+                    cacheSize++;
+                });
+            }
+            std::lock_guard<std::mutex> guard(backgroundLock);
+            warming.store(false, std::memory_order_release);
+        }
+
+        void writeBackEntry(CacheEntry *entry) {
+            if (entry->stored) storage.removeFirst(entry->key);
+            if (!entry->removed) storage.insert(entry->key, entry->value);
+            entry->stored = !entry->removed;
+            entry->dirty = false;
+            dirtyCount--;
+        }
+
+        void touch(CacheEntry *entry) {
+            unlink(entry);
+            pushFront(entry);
+        }
+
+        void pushFront(CacheEntry *entry) {
+            CacheEntry &list = entry->negative ? negativeHead : head;
+            entry->prev = &list, entry->next = list.next;
+            list.next->prev = entry, list.next = entry;
+        }
+
+        static void unlink(CacheEntry *entry) {
+            entry->prev->next = entry->next;
+            entry->next->prev = entry->prev;
         }
     };
 } // namespace trainsys
@@ -0,0 +1,92 @@
+#ifndef DELTA_CODEC_H_
+#define DELTA_CODEC_H_
+
+namespace trainsys {
+    // 定长记录数组的压缩：每条记录先与前一条记录按字节异或，相同的字节变成0，
+    // 再对0做游程编码。有序叶子中相邻记录的键和值大多只有低位不同，压缩效果较好。
+    // 编码格式：控制字节c < 128表示其后跟c + 1个原样字节，c >= 128表示c - 127个0
+
+    // 编码后长度的上界，dst至少要有这么大
+    inline int deltaEncodeBound(int length) {
+        return length + length / 128 + 1;
+    }
+
+    // 压缩src[0, length)，[0, start)原样处理，start之后按stride字节一条记录做差分，返回编码长度
+    inline int deltaEncode(const char *src, int length, int start, int stride, char *dst) {
+        int out = 0, literalBegin = -1;
+        auto byteAt = [&](int i) -> char {
+            return i >= start + stride ? static_cast<char>(src[i] ^ src[i - stride]) : src[i];
+        };
+        int i = 0;
+        while (i < length) {
+            int run = 0;
+            while (i + run < length && run < 128 && byteAt(i + run) == 0) run++;
+            if (run >= 2 || (run == 1 && i + 1 == length)) {
+                dst[out++] = static_cast<char>(127 + run);
+                i += run;
+                literalBegin = -1;
+                continue;
+            }
+            if (literalBegin < 0 || static_cast<unsigned char>(dst[literalBegin]) == 127) {
+                literalBegin = out;
+                dst[out++] = static_cast<char>(-1);
+            }
+            dst[literalBegin] = static_cast<char>(dst[literalBegin] + 1);
+            dst[out++] = byteAt(i++);
+        }
+        return out;
+    }
+
+    // 解压到dst，返回还原出的字节数；参数start、stride须与编码时一致
+    inline int deltaDecode(const char *src, int length, int start, int stride, char *dst) {
+        int out = 0;
+        for (int i = 0; i < length;) {
+            int c = static_cast<unsigned char>(src[i++]);
+            if (c >= 128) {
+                for (int k = 0; k < c - 127; k++) dst[out++] = 0;
+            } else {
+                for (int k = 0; k <= c; k++) dst[out++] = src[i++];
+            }
+        }
+        for (int i = start + stride; i < out; i++) {
+            dst[i] = static_cast<char>(dst[i] ^ dst[i - stride]);
+        }
+        return out;
+    }
+
+    // 变长整数：每字节存7位，低位在前，最高位为1表示后面还有字节；32位整数至多5字节
+    // 有符号数先做zigzag变换（0, -1, 1, -2, ... -> 0, 1, 2, 3, ...），绝对值小的数都只占1字节
+    const int VARINT_MAX_LENGTH = 5;
+
+    inline unsigned zigzagEncode(int value) {
+        return (static_cast<unsigned>(value) << 1) ^ (value < 0 ? ~0U : 0U);
+    }
+
+    inline int zigzagDecode(unsigned value) {
+        return static_cast<int>((value >> 1) ^ (0U - (value & 1)));
+    }
+
+    // 把value写到dst，返回写入的字节数
+    inline int varintEncode(unsigned value, char *dst) {
+        int out = 0;
+        while (value >= 0x80) {
+            dst[out++] = static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        dst[out++] = static_cast<char>(value);
+        return out;
+    }
+
+    // 从[src, end)读出一个变长整数，返回读取的字节数；数据被截断或超过5字节时返回0
+    inline int varintDecode(const char *src, const char *end, unsigned &value) {
+        value = 0;
+        for (int i = 0; i < VARINT_MAX_LENGTH && src + i < end; i++) {
+            unsigned byte = static_cast<unsigned char>(src[i]);
+            value |= (byte & 0x7f) << (7 * i);
+            if (byte < 0x80) return i + 1;
+        }
+        return 0;
+    }
+}
+
+#endif // DELTA_CODEC_H_
@@ -29,6 +29,10 @@ namespace trainsys {
             }
         }
 
+        void clear() {
+            for (int i = 0; i < size; ++i) parent[i] = -1;
+        }
+
         int find(int x) {
             if (parent[x] < 0) return x;
             return parent[x] = find(parent[x]);
@@ -0,0 +1,140 @@
+#ifndef EYTZINGER_TABLE_H_
+#define EYTZINGER_TABLE_H_
+
+#include "SearchTable.h"
+
+namespace trainsys {
+    // 适合读多写少的小表：元素按键有序存放在连续数组中，另按Eytzinger（完全二叉树的层序）顺序
+    // 复制一份键供查找，查找时从下标1开始每步只算下一个下标，没有难以预测的分支，访存集中在数组前部
+    // 插入删除在修改有序数组后立即重建层序数组，find不修改任何状态，可以与其他find并发执行；
+    // find返回指向有序数组中元素的指针，通过它修改的值不会丢失，指针在下一次修改前有效
+    template<class KeyType, class ValueType>
+    class EytzingerTable : public DynamicSearchTable<KeyType, ValueType> {
+    private:
+        DataType<KeyType, ValueType> *sorted;
+        KeyType *layout; // layout[1..size]
+        int *rank;       // rank[k]为layout[k]在sorted中的下标
+        int size, capacity;
+
+    public:
+        EytzingerTable(int initCapacity = 16);
+
+        EytzingerTable(const EytzingerTable &) = delete;
+
+        EytzingerTable &operator=(const EytzingerTable &) = delete;
+
+        ~EytzingerTable();
+
+        DataType<KeyType, ValueType> *find(const KeyType &x) const;
+
+        void insert(const DataType<KeyType, ValueType> &x);
+
+        void remove(const KeyType &x);
+
+        int length() const { return size; }
+
+    private:
+        int lowerBound(const KeyType &x) const;
+
+        int build(int i, int k);
+
+        void rebuild();
+    };
+
+    template<class KeyType, class ValueType>
+    EytzingerTable<KeyType, ValueType>::EytzingerTable(int initCapacity) {
+        capacity = initCapacity > 0 ? initCapacity : 1;
+        size = 0;
+        sorted = new DataType<KeyType, ValueType>[capacity];
+        layout = new KeyType[capacity + 1];
+        rank = new int[capacity + 1];
+    }
+
+    template<class KeyType, class ValueType>
+    EytzingerTable<KeyType, ValueType>::~EytzingerTable() {
+        delete[] sorted;
+        delete[] layout;
+        delete[] rank;
+    }
+
+    template<class KeyType, class ValueType>
+    DataType<KeyType, ValueType> *EytzingerTable<KeyType, ValueType>::find(const KeyType &x) const {
+        int k = 1;
+        while (k <= size) {
+#if defined(__GNUC__)
+            // 预取4层以下的结点，超出表尾时改为预取表头，不构造越界的指针
+            __builtin_prefetch(layout + (16 * k <= size ? 16 * k : 0));
+#endif
+            k = 2 * k + (layout[k] < x);
+        }
+        // 去掉末尾连续的1（向右走的步）和最后一次向左走的步，得到第一个不小于x的结点
+#if defined(__GNUC__)
+        k >>= __builtin_ffs(~k);
+#else
+        while (k & 1) k >>= 1;
+        k >>= 1;
+#endif
+        if (k == 0 || !(layout[k] == x)) return nullptr;
+        return &sorted[rank[k]];
+    }
+
+    template<class KeyType, class ValueType>
+    void EytzingerTable<KeyType, ValueType>::insert(const DataType<KeyType, ValueType> &x) {
+        int pos = lowerBound(x.key);
+        if (pos < size && sorted[pos].key == x.key) return;
+        if (size == capacity) {
+            DataType<KeyType, ValueType> *tmp = sorted;
+            capacity *= 2;
+            sorted = new DataType<KeyType, ValueType>[capacity];
+            for (int i = 0; i < size; ++i) sorted[i] = tmp[i];
+            delete[] tmp;
+            delete[] layout;
+            delete[] rank;
+            layout = new KeyType[capacity + 1];
+            rank = new int[capacity + 1];
+        }
+        for (int i = size; i > pos; --i) sorted[i] = sorted[i - 1];
+        sorted[pos] = x;
+        ++size;
+        rebuild();
+    }
+
+    template<class KeyType, class ValueType>
+    void EytzingerTable<KeyType, ValueType>::remove(const KeyType &x) {
+        int pos = lowerBound(x);
+        if (pos == size || !(sorted[pos].key == x)) return;
+        for (int i = pos; i + 1 < size; ++i) sorted[i] = sorted[i + 1];
+        --size;
+        rebuild();
+    }
+
+    template<class KeyType, class ValueType>
+    int EytzingerTable<KeyType, ValueType>::lowerBound(const KeyType &x) const {
+        int l = 0, r = size;
+        while (l < r) {
+            int mid = (l + r) >> 1;
+            if (sorted[mid].key < x) l = mid + 1;
+            else r = mid;
+        }
+        return l;
+    }
+
+    // 按中序遍历完全二叉树的顺序依次放入有序元素，返回下一个待放入元素的下标
+    template<class KeyType, class ValueType>
+    int EytzingerTable<KeyType, ValueType>::build(int i, int k) {
+        if (k <= size) {
+            i = build(i, 2 * k);
+            layout[k] = sorted[i].key;
+            rank[k] = i++;
+            i = build(i, 2 * k + 1);
+        }
+        return i;
+    }
+
+    template<class KeyType, class ValueType>
+    void EytzingerTable<KeyType, ValueType>::rebuild() {
+        build(0, 1);
+    }
+} // namespace trainsys
+
+#endif // EYTZINGER_TABLE_H_
@@ -0,0 +1,52 @@
+#ifndef FILE_SYNC_H_
+#define FILE_SYNC_H_
+
+#include <filesystem>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace trainsys {
+    // 把文件内容刷到磁盘；文件不存在或刷写失败时返回false
+    inline bool syncFile(const char *filename) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        bool ok = FlushFileBuffers(file) != 0;
+        CloseHandle(file);
+        return ok;
+#else
+        int fd = ::open(filename, O_RDWR);
+        if (fd < 0) return false;
+        bool ok = fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    // 把目录中文件的创建、删除和改名刷到磁盘。Windows上目录的元数据由文件系统日志保证，不需要单独刷写
+    inline bool syncDirectory(const char *path) {
+#ifdef _WIN32
+        return true;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        bool ok = fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    // 刷写name所在的目录，使其中文件的创建、改名和删除落盘
+    inline bool syncDirectoryOf(const std::string &name) {
+        std::string directory = std::filesystem::path(name).parent_path().string();
+        return syncDirectory(directory.empty() ? "." : directory.c_str());
+    }
+} // namespace trainsys
+
+#endif // FILE_SYNC_H_
@@ -0,0 +1,37 @@
+#ifndef FORMAT_VERSION_H_
+#define FORMAT_VERSION_H_
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "FileSync.h"
+
+namespace trainsys {
+    // 由多个文件组成的数据（例如一棵B+树）的格式版本，记在name_version中
+    // 没有版本文件时返回0，由调用者根据数据文件是否存在判断是新建的数据还是加入版本号之前的旧数据
+    inline int readFormatVersion(const std::string &name) {
+        std::ifstream fin(name + "_version", std::ios::in);
+        int version = 0;
+        if (!(fin >> version)) return 0;
+        return version;
+    }
+
+    // 先写临时文件并刷盘，再改名覆盖旧的版本文件，中途崩溃时版本文件要么是旧版本，要么是新版本
+    inline void writeFormatVersion(const std::string &name, int version) {
+        std::string versionFile = name + "_version", tmpFile = versionFile + ".tmp";
+        {
+            std::ofstream fout(tmpFile, std::ios::out | std::ios::trunc);
+            fout << version << std::endl;
+            if (!fout) throw std::runtime_error("Failed to write format version");
+        }
+        if (!syncFile(tmpFile.c_str())) throw std::runtime_error("Failed to write format version");
+        std::error_code error;
+        std::filesystem::rename(tmpFile, versionFile, error);
+        if (error || !syncDirectoryOf(versionFile)) {
+            throw std::runtime_error("Failed to write format version");
+        }
+    }
+} // namespace trainsys
+
+#endif // FORMAT_VERSION_H_
@@ -81,7 +81,7 @@ namespace trainsys {
     void adjListGraph<edgeType>::remove(int u, int v) {
         edgeNode *p = verList[u], *q;
 
-        if (p != nullptr) return;
+        if (p == nullptr) return;
         if (p->end == v) {
             verList[u] = p->next;
             delete p;
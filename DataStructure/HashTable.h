@@ -0,0 +1,135 @@
+#ifndef HASH_TABLE_H_
+#define HASH_TABLE_H_
+
+#include <type_traits>
+#include "SearchTable.h"
+
+namespace trainsys {
+    template<class KeyType>
+    struct Hash {
+        static_assert(std::is_integral<KeyType>::value, "Hash needs a specialization for non-integral keys");
+
+        unsigned long long operator()(const KeyType &key) const {
+            unsigned long long x = static_cast<unsigned long long>(key) + 0x9e3779b97f4a7c15ULL;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        }
+    };
+
+    // 开放定址的Robin Hood哈希表，所有元素存放在一块连续数组中，插入删除不单独分配内存
+    // probe[i]记录第i个槽中的元素离它的理想位置有多远，-1表示空槽
+    template<class KeyType, class ValueType>
+    class HashTable : public DynamicSearchTable<KeyType, ValueType> {
+    private:
+        DataType<KeyType, ValueType> *slots;
+        int *probe;
+        int capacity, size;
+
+    public:
+        HashTable(int initCapacity = 16);
+
+        HashTable(const HashTable &) = delete;
+
+        HashTable &operator=(const HashTable &) = delete;
+
+        ~HashTable();
+
+        DataType<KeyType, ValueType> *find(const KeyType &x) const;
+
+        void insert(const DataType<KeyType, ValueType> &x);
+
+        void remove(const KeyType &x);
+
+        int length() const { return size; }
+
+    private:
+        int home(const KeyType &x) const {
+            return static_cast<int>(Hash<KeyType>()(x) & (capacity - 1));
+        }
+
+        void place(DataType<KeyType, ValueType> x);
+
+        void rehash(int newCapacity);
+    };
+
+    template<class KeyType, class ValueType>
+    HashTable<KeyType, ValueType>::HashTable(int initCapacity) {
+        capacity = 16;
+        while (capacity < initCapacity) capacity <<= 1;
+        size = 0;
+        slots = new DataType<KeyType, ValueType>[capacity];
+        probe = new int[capacity];
+        for (int i = 0; i < capacity; ++i) probe[i] = -1;
+    }
+
+    template<class KeyType, class ValueType>
+    HashTable<KeyType, ValueType>::~HashTable() {
+        delete[] slots;
+        delete[] probe;
+    }
+
+    template<class KeyType, class ValueType>
+    DataType<KeyType, ValueType> *HashTable<KeyType, ValueType>::find(const KeyType &x) const {
+        for (int i = home(x), dist = 0; probe[i] >= dist; i = (i + 1) & (capacity - 1), ++dist) {
+            if (slots[i].key == x) return &slots[i];
+        }
+        return nullptr;
+    }
+
+    template<class KeyType, class ValueType>
+    void HashTable<KeyType, ValueType>::insert(const DataType<KeyType, ValueType> &x) {
+        if (find(x.key) != nullptr) return;
+        if ((size + 1) * 8 > capacity * 7) rehash(capacity * 2);
+        place(x);
+        ++size;
+    }
+
+    template<class KeyType, class ValueType>
+    void HashTable<KeyType, ValueType>::place(DataType<KeyType, ValueType> x) {
+        for (int i = home(x.key), dist = 0;; i = (i + 1) & (capacity - 1), ++dist) {
+            if (probe[i] < 0) {
+                slots[i] = x;
+                probe[i] = dist;
+                return;
+            }
+            if (probe[i] < dist) {
+                DataType<KeyType, ValueType> tmp = slots[i];
+                slots[i] = x, x = tmp;
+                int tmpDist = probe[i];
+                probe[i] = dist, dist = tmpDist;
+            }
+        }
+    }
+
+    template<class KeyType, class ValueType>
+    void HashTable<KeyType, ValueType>::remove(const KeyType &x) {
+        DataType<KeyType, ValueType> *found = find(x);
+        if (found == nullptr) return;
+        int i = found - slots;
+        for (int j = (i + 1) & (capacity - 1); probe[j] > 0; i = j, j = (j + 1) & (capacity - 1)) {
+            slots[i] = slots[j];
+            probe[i] = probe[j] - 1;
+        }
+        probe[i] = -1;
+        --size;
+    }
+
+    template<class KeyType, class ValueType>
+    void HashTable<KeyType, ValueType>::rehash(int newCapacity) {
+        DataType<KeyType, ValueType> *oldSlots = slots;
+        int *oldProbe = probe;
+        int oldCapacity = capacity;
+        capacity = newCapacity;
+        slots = new DataType<KeyType, ValueType>[capacity];
+        probe = new int[capacity];
+        for (int i = 0; i < capacity; ++i) probe[i] = -1;
+        for (int i = 0; i < oldCapacity; ++i) {
+            if (oldProbe[i] >= 0) place(oldSlots[i]);
+        }
+        delete[] oldSlots;
+        delete[] oldProbe;
+    }
+} // namespace trainsys
+
+#endif // HASH_TABLE_H_
@@ -0,0 +1,38 @@
+#ifndef INDEX_ORDER_H_
+#define INDEX_ORDER_H_
+
+namespace trainsys {
+    // 定长小数组的有序下标表：order中按(keys[order[k]], order[k])升序存放数组下标，数组本身保持原来的顺序
+    // 下标只占一个字节，数组长度不能超过256；按值查找时在order上二分，同一个值出现多次时找到下标最小的一次
+
+    // 把keys[0, n)的下标排好序写入order
+    template<class KeyType>
+    void buildIndexOrder(const KeyType *keys, int n, unsigned char *order) {
+        for (int i = 0; i < n; ++i) {
+            int j = i;
+            // 按下标从小到大插入，值相同时新下标排在后面
+            for (; j > 0 && keys[i] < keys[order[j - 1]]; --j) {
+                order[j] = order[j - 1];
+            }
+            order[j] = static_cast<unsigned char>(i);
+        }
+    }
+
+    // 返回key在keys[0, n)中第一次出现的下标，不存在时返回-1
+    // 循环次数只取决于n，每步用条件传送代替分支，不会因预测失败而停顿
+    template<class KeyType>
+    int findInIndexOrder(const KeyType *keys, const unsigned char *order, int n, const KeyType &key) {
+        if (n == 0) {
+            return -1;
+        }
+        const unsigned char *base = order;
+        while (n > 1) {
+            int half = n / 2;
+            base += keys[base[half - 1]] < key ? half : 0;
+            n -= half;
+        }
+        return keys[*base] == key ? *base : -1;
+    }
+} // namespace trainsys
+
+#endif // INDEX_ORDER_H_
@@ -0,0 +1,109 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace trainsys {
+    // 只读内存映射文件，打开后文件内容可以像数组一样直接访问，页面由操作系统按需载入
+    class MappedFile {
+    private:
+        const char *view;
+        long long length;
+#ifdef _WIN32
+        HANDLE file, mapping;
+#endif
+
+    public:
+        MappedFile() : view(nullptr), length(0) {
+#ifdef _WIN32
+            file = INVALID_HANDLE_VALUE;
+            mapping = nullptr;
+#endif
+        }
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile() {
+            close();
+        }
+
+        // 文件不存在、为空或映射失败时返回false
+        bool open(const char *filename);
+
+        void close();
+
+        const char *data() const { return view; }
+
+        long long size() const { return length; }
+    };
+
+#ifdef _WIN32
+    inline bool MappedFile::open(const char *filename) {
+        close();
+        file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            close();
+            return false;
+        }
+        view = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (view == nullptr) {
+            close();
+            return false;
+        }
+        length = fileSize.QuadPart;
+        return true;
+    }
+
+    inline void MappedFile::close() {
+        if (view != nullptr) UnmapViewOfFile(view);
+        if (mapping != nullptr) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        view = nullptr;
+        length = 0;
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+    }
+#else
+    inline bool MappedFile::open(const char *filename) {
+        close();
+        int fd = ::open(filename, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        view = static_cast<const char *>(p);
+        length = st.st_size;
+        return true;
+    }
+
+    inline void MappedFile::close() {
+        if (view != nullptr) munmap(const_cast<char *>(view), length);
+        view = nullptr;
+        length = 0;
+    }
+#endif
+} // namespace trainsys
+
+#endif // MAPPED_FILE_H_
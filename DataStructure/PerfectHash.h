@@ -0,0 +1,173 @@
+#ifndef PERFECT_HASH_H_
+#define PERFECT_HASH_H_
+
+#include <cstring>
+#include <stdexcept>
+#include "HashTable.h"
+
+namespace trainsys {
+    // 静态字符串集合上的最小完美哈希（CHD，hash and displace）：
+    // 键按哈希值分到约n/4个桶，从大桶到小桶依次为每个桶找一个位移量，使桶内的键落到互不冲突的空位上，
+    // 建好后n个键恰好一一映射到[0, n)，查询只需两次哈希和一次查表
+    // 不在集合中的键也会映射到某个位置，调用者需要自行比较该位置上的键
+    class PerfectHash {
+    private:
+        static const int KEYS_PER_BUCKET = 4;
+        static const int MAX_DISPLACEMENT = 1 << 16;
+        static const int MAX_ATTEMPTS = 32;
+
+        int keyCount, bucketCount;
+        unsigned long long seed;
+        const int *displacement;
+        int *ownedDisplacement; // build()建出的位移表，attach()时为空
+
+    public:
+        PerfectHash() : keyCount(0), bucketCount(0), seed(0), displacement(nullptr), ownedDisplacement(nullptr) {
+        }
+
+        PerfectHash(const PerfectHash &) = delete;
+
+        PerfectHash &operator=(const PerfectHash &) = delete;
+
+        ~PerfectHash() {
+            delete[] ownedDisplacement;
+        }
+
+        int size() const { return keyCount; }
+
+        int getBucketCount() const { return bucketCount; }
+
+        unsigned long long getSeed() const { return seed; }
+
+        // 长度为getBucketCount()的位移表，可以连同种子一起存盘，之后用attach()直接使用
+        const int *getDisplacement() const { return displacement; }
+
+        // keys中不能有重复的字符串，否则抛出std::invalid_argument
+        void build(const char *const *keys, int n);
+
+        // 使用外部（例如内存映射文件中）的位移表，不复制也不负责释放
+        void attach(int n, int buckets, unsigned long long hashSeed, const int *table) {
+            delete[] ownedDisplacement;
+            ownedDisplacement = nullptr;
+            keyCount = n, bucketCount = buckets, seed = hashSeed, displacement = table;
+        }
+
+        // 返回key在[0, n)中的位置，集合为空时返回-1
+        int operator()(const char *key) const {
+            if (keyCount == 0) return -1;
+            unsigned long long h = hashString(key, seed);
+            return slotOf(h, displacement[bucketOf(h)]);
+        }
+
+    private:
+        static unsigned long long hashString(const char *key, unsigned long long seed) {
+            unsigned long long h = 0xcbf29ce484222325ULL ^ seed;
+            for (; *key; ++key) {
+                h ^= static_cast<unsigned char>(*key);
+                h *= 0x100000001b3ULL;
+            }
+            return Hash<unsigned long long>()(h);
+        }
+
+        int bucketOf(unsigned long long h) const {
+            return static_cast<int>((h >> 32) % bucketCount);
+        }
+
+        int slotOf(unsigned long long h, int d) const {
+            return static_cast<int>(Hash<unsigned long long>()(h + d) % keyCount);
+        }
+
+        bool tryBuild(const unsigned long long *hashes, const int *bucketStart, const int *members,
+                      const int *order, bool *taken, int *slots);
+    };
+
+    inline void PerfectHash::build(const char *const *keys, int n) {
+        delete[] ownedDisplacement;
+        displacement = ownedDisplacement = nullptr;
+        keyCount = n;
+        bucketCount = (n + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET;
+        if (n == 0) return;
+        displacement = ownedDisplacement = new int[bucketCount];
+
+        unsigned long long *hashes = new unsigned long long[n];
+        int *bucketStart = new int[bucketCount + 1];
+        int *members = new int[n];
+        int *order = new int[bucketCount];
+        bool *taken = new bool[n];
+        int *slots = new int[n];
+        bool built = false;
+        for (int attempt = 0; attempt < MAX_ATTEMPTS && !built; ++attempt) {
+            seed = Hash<unsigned long long>()(attempt);
+            for (int i = 0; i < n; ++i) hashes[i] = hashString(keys[i], seed);
+
+            // 按桶分组（计数排序），再按桶大小从大到小排列桶的处理顺序
+            for (int b = 0; b <= bucketCount; ++b) bucketStart[b] = 0;
+            for (int i = 0; i < n; ++i) ++bucketStart[bucketOf(hashes[i]) + 1];
+            int maxBucketSize = 0;
+            for (int b = 0; b < bucketCount; ++b) {
+                if (bucketStart[b + 1] > maxBucketSize) maxBucketSize = bucketStart[b + 1];
+                bucketStart[b + 1] += bucketStart[b];
+            }
+            for (int b = 0; b < bucketCount; ++b) order[b] = bucketStart[b];
+            for (int i = 0; i < n; ++i) members[order[bucketOf(hashes[i])]++] = i;
+            int count = 0;
+            for (int size = maxBucketSize; size >= 0; --size) {
+                for (int b = 0; b < bucketCount; ++b) {
+                    if (bucketStart[b + 1] - bucketStart[b] == size) order[count++] = b;
+                }
+            }
+
+            // 同一个桶里两个键的哈希值相同时任何位移都无法分开，除非键本身重复，换一个种子重来
+            for (int i = 0; i < n; ++i) taken[i] = false;
+            built = tryBuild(hashes, bucketStart, members, order, taken, slots);
+            if (!built) {
+                for (int b = 0; b < bucketCount; ++b) {
+                    for (int i = bucketStart[b]; i < bucketStart[b + 1]; ++i) {
+                        for (int j = bucketStart[b]; j < i; ++j) {
+                            if (strcmp(keys[members[i]], keys[members[j]]) == 0) {
+                                delete[] hashes, delete[] bucketStart, delete[] members;
+                                delete[] order, delete[] taken, delete[] slots;
+                                throw std::invalid_argument("Duplicate key in perfect hash");
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        delete[] hashes, delete[] bucketStart, delete[] members;
+        delete[] order, delete[] taken, delete[] slots;
+        if (!built) throw std::runtime_error("Failed to build perfect hash");
+    }
+
+    inline bool PerfectHash::tryBuild(const unsigned long long *hashes, const int *bucketStart, const int *members,
+                                      const int *order, bool *taken, int *slots) {
+        for (int k = 0; k < bucketCount; ++k) {
+            int b = order[k];
+            int first = bucketStart[b], last = bucketStart[b + 1];
+            if (first == last) {
+                ownedDisplacement[b] = 0;
+                continue;
+            }
+            bool placed = false;
+            for (int d = 0; d < MAX_DISPLACEMENT && !placed; ++d) {
+                int i = first;
+                for (; i < last; ++i) {
+                    int slot = slotOf(hashes[members[i]], d);
+                    if (taken[slot]) break;
+                    taken[slot] = true;
+                    slots[i] = slot;
+                }
+                if (i == last) {
+                    ownedDisplacement[b] = d;
+                    placed = true;
+                } else {
+                    for (int j = first; j < i; ++j) taken[slots[j]] = false;
+                }
+            }
+            if (!placed) return false;
+        }
+        return true;
+    }
+} // namespace trainsys
+
+#endif // PERFECT_HASH_H_
@@ -0,0 +1,105 @@
+#ifndef POOL_ALLOCATOR_H_
+#define POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+
+namespace trainsys {
+    // 定长结点的内存池：按块（slab）成批申请内存，块按缓存行对齐，
+    // 释放的结点挂到空闲链表上供下次分配复用，内存池析构时整块归还
+    // allocate只分配内存，调用者用placement new构造对象，deallocate前需自行析构
+    template<class T>
+    class PoolAllocator {
+    private:
+        static const std::size_t CACHE_LINE_SIZE = 64;
+        static const std::size_t SLAB_BYTES = 4096;
+
+        union Slot {
+            Slot *next;
+            alignas(T) char storage[sizeof(T)];
+        };
+
+        struct Slab {
+            Slab *next;
+        };
+
+        static const std::size_t SLOT_OFFSET = (sizeof(Slab) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+        static const std::size_t SLOTS_PER_SLAB =
+            (SLAB_BYTES - SLOT_OFFSET) / sizeof(Slot) > 16 ? (SLAB_BYTES - SLOT_OFFSET) / sizeof(Slot) : 16;
+
+        Slab *slabs;
+        Slot *freeList;
+        Slot *nextUnused; // 最新一块中尚未用过的位置，用完后再申请新块
+        Slot *slabEnd;
+
+    public:
+        static const bool BULK_RELEASE = true; // release()能一次归还所有结点
+
+        PoolAllocator() : slabs(nullptr), freeList(nullptr), nextUnused(nullptr), slabEnd(nullptr) {
+        }
+
+        PoolAllocator(const PoolAllocator &) = delete;
+
+        PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+        ~PoolAllocator() {
+            release();
+        }
+
+        T *allocate() {
+            if (freeList != nullptr) {
+                Slot *slot = freeList;
+                freeList = slot->next;
+                return reinterpret_cast<T *>(slot->storage);
+            }
+            if (nextUnused == slabEnd) newSlab();
+            return reinterpret_cast<T *>((nextUnused++)->storage);
+        }
+
+        void deallocate(T *p) {
+            Slot *slot = reinterpret_cast<Slot *>(p);
+            slot->next = freeList;
+            freeList = slot;
+        }
+
+        // 归还所有块，之前分配出去的结点全部失效
+        void release() {
+            while (slabs != nullptr) {
+                Slab *next = slabs->next;
+                ::operator delete(slabs, std::align_val_t(CACHE_LINE_SIZE));
+                slabs = next;
+            }
+            freeList = nextUnused = slabEnd = nullptr;
+        }
+
+    private:
+        void newSlab() {
+            std::size_t bytes = SLOT_OFFSET + SLOTS_PER_SLAB * sizeof(Slot);
+            Slab *slab = static_cast<Slab *>(::operator new(bytes, std::align_val_t(CACHE_LINE_SIZE)));
+            slab->next = slabs;
+            slabs = slab;
+            nextUnused = reinterpret_cast<Slot *>(reinterpret_cast<char *>(slab) + SLOT_OFFSET);
+            slabEnd = nextUnused + SLOTS_PER_SLAB;
+        }
+    };
+
+    // 直接使用new/delete的分配器，接口与PoolAllocator相同
+    template<class T>
+    class NewAllocator {
+    public:
+        static const bool BULK_RELEASE = false;
+
+        T *allocate() {
+            return static_cast<T *>(::operator new(sizeof(T)));
+        }
+
+        void deallocate(T *p) {
+            ::operator delete(p);
+        }
+
+        void release() {
+        }
+    };
+}
+
+#endif // POOL_ALLOCATOR_H_
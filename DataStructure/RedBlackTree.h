@@ -1,10 +1,14 @@
 #ifndef RED_BLACK_TREE_H_
 #define RED_BLACK_TREE_H_
 
+#include <new>
+#include <type_traits>
 #include "SearchTable.h"
+#include "PoolAllocator.h"
 
 namespace trainsys {
-    template<class KeyType, class ValueType>
+    // Allocator为结点分配器，默认从按块申请的内存池中分配结点
+    template<class KeyType, class ValueType, template<class> class Allocator = PoolAllocator>
     class RedBlackTree : public DynamicSearchTable<KeyType, ValueType> {
     private:
         enum Color { RED, BLACK };
@@ -32,6 +36,7 @@ namespace trainsys {
 
     private:
         RedBlackNode *root;
+        Allocator<RedBlackNode> nodeAllocator;
 
     public:
         RedBlackTree();
@@ -41,6 +46,8 @@ namespace trainsys {
     private:
         void makeEmpty(RedBlackNode *u);
 
+        void destroyNode(RedBlackNode *u);
+
         void LL(RedBlackNode *t);
 
         void RR(RedBlackNode *t);
@@ -66,25 +73,35 @@ namespace trainsys {
         void remove(const KeyType &x, RedBlackNode *&t);
     };
 
-    template<class KeyType, class ValueType>
-    RedBlackTree<KeyType, ValueType>::RedBlackTree() {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    RedBlackTree<KeyType, ValueType, Allocator>::RedBlackTree() {
         root = nullptr;
     }
 
-    template<class KeyType, class ValueType>
-    RedBlackTree<KeyType, ValueType>::~RedBlackTree() {
-        if (root != nullptr) makeEmpty(root);
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    RedBlackTree<KeyType, ValueType, Allocator>::~RedBlackTree() {
+        if (std::is_trivially_destructible<RedBlackNode>::value && Allocator<RedBlackNode>::BULK_RELEASE) {
+            nodeAllocator.release();
+        } else if (root != nullptr) {
+            makeEmpty(root);
+        }
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::makeEmpty(RedBlackNode *u) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::makeEmpty(RedBlackNode *u) {
         if (u->left) makeEmpty(u->left);
         if (u->right) makeEmpty(u->right);
-        delete u;
+        destroyNode(u);
+    }
+
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::destroyNode(RedBlackNode *u) {
+        u->~RedBlackNode();
+        nodeAllocator.deallocate(u);
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::LL(RedBlackNode *t) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::LL(RedBlackNode *t) {
         RedBlackNode *tmp = t->left;
         t->left = tmp->right;
         if (tmp->right) tmp->right->parent = t;
@@ -101,8 +118,8 @@ namespace trainsys {
         t = tmp;
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::RR(RedBlackNode *t) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::RR(RedBlackNode *t) {
         RedBlackNode *tmp = t->right;
         t->right = tmp->left;
         if (tmp->left) tmp->left->parent = t;
@@ -119,20 +136,20 @@ namespace trainsys {
         t = tmp;
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::LR(RedBlackNode *t) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::LR(RedBlackNode *t) {
         RR(t->left);
         LL(t);
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::RL(RedBlackNode *t) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::RL(RedBlackNode *t) {
         LL(t->right);
         RR(t);
     }
 
-    template<class KeyType, class ValueType>
-    DataType<KeyType, ValueType> *RedBlackTree<KeyType, ValueType>::find(const KeyType &x) const {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    DataType<KeyType, ValueType> *RedBlackTree<KeyType, ValueType, Allocator>::find(const KeyType &x) const {
         RedBlackNode *t = root;
         while (t != nullptr) {
             if (x == t->data.key) return &t->data;
@@ -144,8 +161,8 @@ namespace trainsys {
         return nullptr;
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::insertionRebalance(RedBlackNode *u) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::insertionRebalance(RedBlackNode *u) {
         if (u == nullptr) return;
 
         while (u != root) {
@@ -184,16 +201,16 @@ namespace trainsys {
         root->color = BLACK;
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::insert(const DataType<KeyType, ValueType> &x) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::insert(const DataType<KeyType, ValueType> &x) {
         insert(x, nullptr, root);
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::insert(const DataType<KeyType, ValueType> &x, RedBlackNode *p,
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::insert(const DataType<KeyType, ValueType> &x, RedBlackNode *p,
                                                   RedBlackNode *&t) {
         if (t == nullptr) {
-            t = new RedBlackNode(RED, x, p);
+            t = new (nodeAllocator.allocate()) RedBlackNode(RED, x, p);
             insertionRebalance(t);
         } else if (x.key < t->data.key) {
             insert(x, t, t->left);
@@ -202,8 +219,8 @@ namespace trainsys {
         }
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::removalRebalance(RedBlackNode *u) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::removalRebalance(RedBlackNode *u) {
         if (u == nullptr) return;
         while (u != root) {
             RedBlackNode *p = u->parent;
@@ -261,13 +278,13 @@ namespace trainsys {
         root->color = BLACK;
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::remove(const KeyType &x) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::remove(const KeyType &x) {
         remove(x, root);
     }
 
-    template<class KeyType, class ValueType>
-    void RedBlackTree<KeyType, ValueType>::remove(const KeyType &x, RedBlackNode *&t) {
+    template<class KeyType, class ValueType, template<class> class Allocator>
+    void RedBlackTree<KeyType, ValueType, Allocator>::remove(const KeyType &x, RedBlackNode *&t) {
         if (!t) return;
 
         if (x == t->data.key) {
@@ -289,7 +306,7 @@ namespace trainsys {
                 }
 
                 if (v) v->parent = t->parent;
-                delete t;
+                destroyNode(t);
                 t = v;
             }
         } else if (x < t->data.key) {
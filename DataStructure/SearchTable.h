@@ -9,6 +9,9 @@ namespace trainsys {
         KeyType key;
         ValueType value;
 
+        DataType() {
+        }
+
         DataType(const KeyType &key_, const ValueType &value_): key(key_), value(value_) {
         }
     };
@@ -0,0 +1,148 @@
+#ifndef SHARDED_CACHED_BPLUS_TREE_H_
+#define SHARDED_CACHED_BPLUS_TREE_H_
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "CachedBPlusTree.h"
+#include "HashTable.h"
+
+namespace trainsys {
+    // 线程安全的CachedBPlusTree：按键的哈希值把数据分到ShardCount个分片，
+    // 每个分片有自己的缓存、B+树文件（filename_shard<i>）和互斥锁，
+    // 不同分片上的查询和修改可以并行，一次操作只锁住键所在的分片
+    // 构造时若filename下还有未分片的旧B+树，先把其中的数据按分片批量写入各分片文件，刷盘后再删除旧树
+    template<class KeyType, class ValueType, int ShardCount = 8, template<class, class> class IndexTable = HashTable>
+    class ShardedCachedBPlusTree {
+    private:
+        using ShardType = CachedBPlusTree<KeyType, ValueType, IndexTable>;
+
+        struct Shard {
+            std::mutex lock;
+            ShardType *table;
+        };
+
+        Shard shards[ShardCount];
+
+    public:
+        ShardedCachedBPlusTree(const char *filename, int capacity = ShardType::DEFAULT_CAPACITY,
+                               int negativeCapacity = ShardType::DEFAULT_CAPACITY / 4) {
+            migrateUnsharded(filename);
+            for (int i = 0; i < ShardCount; ++i) {
+                shards[i].table = new ShardType(shardName(filename, i).c_str(), (capacity + ShardCount - 1) / ShardCount,
+                                                (negativeCapacity + ShardCount - 1) / ShardCount);
+            }
+        }
+
+        ~ShardedCachedBPlusTree() {
+            for (int i = 0; i < ShardCount; ++i) delete shards[i].table;
+        }
+
+        bool contains(const KeyType &x) {
+            Shard &shard = shardOf(x);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            return shard.table->contains(x);
+        }
+
+        ValueType find(const KeyType &x) {
+            Shard &shard = shardOf(x);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            return shard.table->find(x);
+        }
+
+        void insert(const KeyType &key, const ValueType &value) {
+            Shard &shard = shardOf(key);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            shard.table->insert(key, value);
+        }
+
+        void remove(const KeyType &x) {
+            Shard &shard = shardOf(x);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            shard.table->remove(x);
+        }
+
+        // 在分片锁内读出key的值交给update修改后写回，key不存在时返回false
+        // 读-改-写整体对同一分片上的其他操作是原子的
+        template<class Updater>
+        bool update(const KeyType &key, Updater update) {
+            Shard &shard = shardOf(key);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            if (!shard.table->contains(key)) return false;
+            ValueType value = shard.table->find(key);
+            update(value);
+            shard.table->insert(key, value);
+            return true;
+        }
+
+        void setWriteBack(bool enabled, int maxDirty = ShardType::DEFAULT_CAPACITY / 4, int maxDelayMillis = 1000) {
+            for (int i = 0; i < ShardCount; ++i) {
+                std::lock_guard<std::mutex> guard(shards[i].lock);
+                shards[i].table->setWriteBack(enabled, (maxDirty + ShardCount - 1) / ShardCount, maxDelayMillis);
+            }
+        }
+
+        void flush() {
+            for (int i = 0; i < ShardCount; ++i) {
+                std::lock_guard<std::mutex> guard(shards[i].lock);
+                shards[i].table->flush();
+            }
+        }
+
+        long long getHitCount() { return sum(&ShardType::getHitCount); }
+        long long getMissCount() { return sum(&ShardType::getMissCount); }
+        long long getEvictionCount() { return sum(&ShardType::getEvictionCount); }
+        long long getNegativeHitCount() { return sum(&ShardType::getNegativeHitCount); }
+
+    private:
+        static std::string shardName(const char *filename, int i) {
+            return std::string(filename) + "_shard" + std::to_string(i);
+        }
+
+        // 旧树的数据全部写入分片并刷盘后才删除旧树；中途崩溃时旧树仍在，下次构造时丢弃分片文件重新迁移
+        static void migrateUnsharded(const char *filename) {
+            typedef BPlusTree<KeyType, ValueType> TreeType;
+            if (!TreeType::exists(filename)) return;
+            std::vector<Pair<KeyType, ValueType> > entries[ShardCount];
+            {
+                TreeType old(filename);
+                old.forEachEntry([&entries](const KeyType &key, const ValueType &value) {
+                    entries[shardIndex(key)].push_back(Pair<KeyType, ValueType>(key, value));
+                });
+            }
+            for (int i = 0; i < ShardCount; ++i) {
+                std::string name = shardName(filename, i);
+                TreeType::destroy(name);
+                std::remove((name + "_hotKeys").c_str());
+                {
+                    TreeType shard(name.c_str());
+                    shard.bulkLoad(entries[i].data(), static_cast<int>(entries[i].size()));
+                }
+                TreeType::sync(name);
+            }
+            TreeType::destroy(filename);
+            std::remove((std::string(filename) + "_hotKeys").c_str());
+        }
+
+        // 分片用哈希值的高位，低位留给分片内的HashTable定位槽位
+        static int shardIndex(const KeyType &x) {
+            return static_cast<int>((Hash<KeyType>()(x) >> 32) % ShardCount);
+        }
+
+        Shard &shardOf(const KeyType &x) {
+            return shards[shardIndex(x)];
+        }
+
+        long long sum(long long (ShardType::*counter)() const) {
+            long long total = 0;
+            for (int i = 0; i < ShardCount; ++i) {
+                std::lock_guard<std::mutex> guard(shards[i].lock);
+                total += (shards[i].table->*counter)();
+            }
+            return total;
+        }
+    };
+} // namespace trainsys
+
+#endif // SHARDED_CACHED_BPLUS_TREE_H_
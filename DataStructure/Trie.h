@@ -0,0 +1,275 @@
+#ifndef TRIE_H_
+#define TRIE_H_
+
+#include <cstring>
+#include "Queue.h"
+
+namespace trainsys {
+    // 字符串键的字典树，所有结点存放在一块连续数组中，兄弟结点按字符从小到大串成链表
+    // 每个键带一个非负的热度，结点记录子树中最大的热度，补全时按热度从高到低取前k个，不必遍历整棵子树
+    // 删除键只清除终结标记，结点不回收
+    template<class ValueType>
+    class Trie {
+    private:
+        struct Node {
+            char ch;
+            bool terminal;
+            int parent, firstChild, nextSibling;
+            long long weight; // 终结结点的热度
+            long long best; // 子树中终结结点热度的最大值，子树中没有键时为-1
+            ValueType value;
+        };
+
+        // 补全时的搜索状态：emit为真表示输出node上的键，否则表示展开node的子树
+        struct SearchState {
+            long long priority;
+            int node;
+            bool emit;
+
+            // priorityQueue是小根堆，这里反过来比较，使热度高的先出队；热度相同时先输出键，再按结点编号
+            bool operator<(const SearchState &rhs) const {
+                if (priority != rhs.priority) return priority > rhs.priority;
+                if (emit != rhs.emit) return emit;
+                return node < rhs.node;
+            }
+        };
+
+        Node *nodes;
+        int nodeCount, capacity, keyCount, maxKeyLength;
+
+    public:
+        Trie(int initCapacity = 64);
+
+        Trie(const Trie &) = delete;
+
+        Trie &operator=(const Trie &) = delete;
+
+        ~Trie() { delete[] nodes; }
+
+        int size() const { return keyCount; }
+
+        // 键已存在时覆盖其值和热度
+        void insert(const char *key, const ValueType &value, long long weight = 0);
+
+        void remove(const char *key);
+
+        bool find(const char *key, ValueType &value) const;
+
+        void addWeight(const char *key, long long delta);
+
+        // 以prefix为前缀的键中热度最高的至多k个，按热度从高到低写入result，返回个数
+        int complete(const char *prefix, ValueType *result, int k) const;
+
+        // 与key的编辑距离不超过maxDistance的键中至多k个，按距离从小到大、热度从高到低写入result，返回个数
+        int fuzzyFind(const char *key, int maxDistance, ValueType *result, int k) const;
+
+    private:
+        int child(int node, char ch) const;
+
+        int locate(const char *key) const;
+
+        int newChild(int node, char ch);
+
+        void raiseBest(int node, long long weight);
+
+        void recomputeBest(int node);
+
+        void fuzzyDfs(int node, int depth, const char *key, int keyLength, int maxDistance, int *rows,
+                      ValueType *result, int *distance, long long *weight, int k, int &count) const;
+    };
+
+    template<class ValueType>
+    Trie<ValueType>::Trie(int initCapacity) {
+        capacity = initCapacity > 1 ? initCapacity : 1;
+        nodes = new Node[capacity];
+        nodes[0].ch = '\0';
+        nodes[0].terminal = false;
+        nodes[0].parent = nodes[0].firstChild = nodes[0].nextSibling = -1;
+        nodes[0].weight = 0;
+        nodes[0].best = -1;
+        nodeCount = 1;
+        keyCount = maxKeyLength = 0;
+    }
+
+    template<class ValueType>
+    void Trie<ValueType>::insert(const char *key, const ValueType &value, long long weight) {
+        int node = 0, length = 0;
+        for (; key[length]; ++length) {
+            int next = child(node, key[length]);
+            node = next >= 0 ? next : newChild(node, key[length]);
+        }
+        if (length > maxKeyLength) maxKeyLength = length;
+        bool existed = nodes[node].terminal;
+        long long oldWeight = nodes[node].weight;
+        if (!existed) ++keyCount;
+        nodes[node].terminal = true;
+        nodes[node].value = value;
+        nodes[node].weight = weight;
+        if (existed && weight < oldWeight) recomputeBest(node);
+        else raiseBest(node, weight);
+    }
+
+    template<class ValueType>
+    void Trie<ValueType>::remove(const char *key) {
+        int node = locate(key);
+        if (node < 0 || !nodes[node].terminal) return;
+        nodes[node].terminal = false;
+        --keyCount;
+        recomputeBest(node);
+    }
+
+    template<class ValueType>
+    bool Trie<ValueType>::find(const char *key, ValueType &value) const {
+        int node = locate(key);
+        if (node < 0 || !nodes[node].terminal) return false;
+        value = nodes[node].value;
+        return true;
+    }
+
+    template<class ValueType>
+    void Trie<ValueType>::addWeight(const char *key, long long delta) {
+        int node = locate(key);
+        if (node < 0 || !nodes[node].terminal) return;
+        nodes[node].weight += delta;
+        if (delta >= 0) raiseBest(node, nodes[node].weight);
+        else recomputeBest(node);
+    }
+
+    template<class ValueType>
+    int Trie<ValueType>::complete(const char *prefix, ValueType *result, int k) const {
+        int node = locate(prefix);
+        if (node < 0 || nodes[node].best < 0 || k <= 0) return 0;
+        priorityQueue<SearchState> queue;
+        queue.enQueue(SearchState{nodes[node].best, node, false});
+        int count = 0;
+        while (!queue.isEmpty() && count < k) {
+            SearchState state = queue.deQueue();
+            const Node &cur = nodes[state.node];
+            if (state.emit) {
+                result[count++] = cur.value;
+                continue;
+            }
+            if (cur.terminal) queue.enQueue(SearchState{cur.weight, state.node, true});
+            for (int c = cur.firstChild; c >= 0; c = nodes[c].nextSibling) {
+                if (nodes[c].best >= 0) queue.enQueue(SearchState{nodes[c].best, c, false});
+            }
+        }
+        return count;
+    }
+
+    template<class ValueType>
+    int Trie<ValueType>::fuzzyFind(const char *key, int maxDistance, ValueType *result, int k) const {
+        if (k <= 0 || maxDistance < 0 || keyCount == 0) return 0;
+        int keyLength = strlen(key);
+        // rows[d]为键的前d个字符与key各前缀的编辑距离，逐层向下只需计算新的一行
+        int *rows = new int[(maxKeyLength + 1) * (keyLength + 1)];
+        int *distance = new int[k];
+        long long *weight = new long long[k];
+        for (int j = 0; j <= keyLength; ++j) rows[j] = j;
+        int count = 0;
+        fuzzyDfs(0, 0, key, keyLength, maxDistance, rows, result, distance, weight, k, count);
+        delete[] rows;
+        delete[] distance;
+        delete[] weight;
+        return count;
+    }
+
+    template<class ValueType>
+    void Trie<ValueType>::fuzzyDfs(int node, int depth, const char *key, int keyLength, int maxDistance, int *rows,
+                                   ValueType *result, int *distance, long long *weight, int k, int &count) const {
+        const int *row = rows + depth * (keyLength + 1);
+        const Node &cur = nodes[node];
+        if (cur.terminal && row[keyLength] <= maxDistance) {
+            // 按（距离，热度）插入排序，只保留前k个
+            int d = row[keyLength], pos = count < k ? count : k - 1;
+            if (count < k || d < distance[pos] || (d == distance[pos] && cur.weight > weight[pos])) {
+                if (count < k) ++count;
+                for (; pos > 0 && (distance[pos - 1] > d || (distance[pos - 1] == d && weight[pos - 1] < cur.weight));
+                       --pos) {
+                    distance[pos] = distance[pos - 1];
+                    weight[pos] = weight[pos - 1];
+                    result[pos] = result[pos - 1];
+                }
+                distance[pos] = d;
+                weight[pos] = cur.weight;
+                result[pos] = cur.value;
+            }
+        }
+        // 已找满k个时，距离大于当前最差结果的分支不可能更好
+        int limit = count == k ? distance[k - 1] : maxDistance;
+        int *next = rows + (depth + 1) * (keyLength + 1);
+        for (int c = cur.firstChild; c >= 0; c = nodes[c].nextSibling) {
+            if (nodes[c].best < 0) continue;
+            next[0] = depth + 1;
+            int rowMin = next[0];
+            for (int j = 1; j <= keyLength; ++j) {
+                int cost = row[j - 1] + (key[j - 1] != nodes[c].ch);
+                if (row[j] + 1 < cost) cost = row[j] + 1;
+                if (next[j - 1] + 1 < cost) cost = next[j - 1] + 1;
+                next[j] = cost;
+                if (cost < rowMin) rowMin = cost;
+            }
+            if (rowMin <= limit) {
+                fuzzyDfs(c, depth + 1, key, keyLength, maxDistance, rows, result, distance, weight, k, count);
+                limit = count == k ? distance[k - 1] : maxDistance;
+            }
+        }
+    }
+
+    template<class ValueType>
+    int Trie<ValueType>::child(int node, char ch) const {
+        int c = nodes[node].firstChild;
+        while (c >= 0 && nodes[c].ch < ch) c = nodes[c].nextSibling;
+        return c >= 0 && nodes[c].ch == ch ? c : -1;
+    }
+
+    template<class ValueType>
+    int Trie<ValueType>::locate(const char *key) const {
+        int node = 0;
+        for (; *key && node >= 0; ++key) node = child(node, *key);
+        return node;
+    }
+
+    template<class ValueType>
+    int Trie<ValueType>::newChild(int node, char ch) {
+        if (nodeCount == capacity) {
+            Node *tmp = nodes;
+            capacity *= 2;
+            nodes = new Node[capacity];
+            for (int i = 0; i < nodeCount; ++i) nodes[i] = tmp[i];
+            delete[] tmp;
+        }
+        int c = nodeCount++;
+        nodes[c].ch = ch;
+        nodes[c].terminal = false;
+        nodes[c].parent = node;
+        nodes[c].firstChild = -1;
+        nodes[c].weight = 0;
+        nodes[c].best = -1;
+        // 插入到兄弟链表中保持字符有序
+        int *link = &nodes[node].firstChild;
+        while (*link >= 0 && nodes[*link].ch < ch) link = &nodes[*link].nextSibling;
+        nodes[c].nextSibling = *link;
+        *link = c;
+        return c;
+    }
+
+    template<class ValueType>
+    void Trie<ValueType>::raiseBest(int node, long long weight) {
+        for (; node >= 0 && nodes[node].best < weight; node = nodes[node].parent) nodes[node].best = weight;
+    }
+
+    template<class ValueType>
+    void Trie<ValueType>::recomputeBest(int node) {
+        for (; node >= 0; node = nodes[node].parent) {
+            long long best = nodes[node].terminal ? nodes[node].weight : -1;
+            for (int c = nodes[node].firstChild; c >= 0; c = nodes[c].nextSibling) {
+                if (nodes[c].best > best) best = nodes[c].best;
+            }
+            if (best == nodes[node].best) break;
+            nodes[node].best = best;
+        }
+    }
+} // namespace trainsys
+
+#endif // TRIE_H_
@@ -1,22 +1,48 @@
 #ifndef DATETIME_H_
 #define DATETIME_H_
 
+#include <cstdint>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 namespace trainsys {
-    const int mday_number_[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-    const int prefix_total_[13] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365};
+    constexpr int mday_number_[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    constexpr int prefix_total_[13] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365};
 
+    const int DAYS_PER_YEAR = 365;
+    const int MINUTES_PER_DAY = 1440;
+
+    // 一年中第几天（从0开始）所在的月份
+    struct MonthTable {
+        unsigned char month[DAYS_PER_YEAR];
+
+        constexpr MonthTable() : month() {
+            for (int mon = 1, day = 0; mon <= 12; ++mon) {
+                for (int i = 0; i < mday_number_[mon]; ++i) month[day++] = mon;
+            }
+        }
+    };
+
+    inline constexpr MonthTable month_of_day_{};
+
+    // 向下取整的余数，结果在[0, b)内
+    inline int floorMod(int a, int b) {
+        int r = a % b;
+        return r < 0 ? r + b : r;
+    }
+
+    // 日期只保存一年中的第几天（01-01为0），比较和加减都是整数运算，月和日按需换算
+    // 日期不带年份，加减越过年末或年初时回绕到相邻一年的同一天，例如12-31加1天为01-01；
+    // 比较只在同一年内有意义。由字符串或月日构造非法日期时抛出std::invalid_argument
     struct Date {
-        int mon;
-        int mday;
+        uint16_t day;
 
         Date() = default;
 
-        Date(int mday_, int mon_);
+        Date(int mon_, int mday_);
 
         Date(const Date &o) = default;
 
@@ -24,73 +50,113 @@ namespace trainsys {
 
         ~Date() = default;
 
-        Date &operator+=(int days);
+        // day不在[0, DAYS_PER_YEAR)内时抛出std::out_of_range，用于检查从文件中读出的日期
+        static Date ofDay(int day) {
+            if (day < 0 || day >= DAYS_PER_YEAR) throw std::out_of_range("Date out of range");
+            Date ret;
+            ret.day = day;
+            return ret;
+        }
+
+        int mon() const {
+            if (day >= DAYS_PER_YEAR) throw std::out_of_range("Date out of range");
+            return month_of_day_.month[day];
+        }
 
-        Date &operator-=(int days);
+        int mday() const { return day - prefix_total_[mon() - 1] + 1; }
 
-        Date operator+(int days);
+        Date &operator+=(int days) { return *this = ofDay(floorMod(day + days, DAYS_PER_YEAR)); }
 
-        Date operator-(int days);
+        Date &operator-=(int days) { return *this = ofDay(floorMod(day - days, DAYS_PER_YEAR)); }
+
+        Date operator+(int days) const { return ofDay(floorMod(day + days, DAYS_PER_YEAR)); }
+
+        Date operator-(int days) const { return ofDay(floorMod(day - days, DAYS_PER_YEAR)); }
 
         operator std::string() const;
 
         friend std::ostream &operator<<(std::ostream &os, const Date &date);
 
-        friend bool operator==(const Date &lhs, const Date &rhs);
+        friend bool operator==(const Date &lhs, const Date &rhs) { return lhs.day == rhs.day; }
 
-        friend bool operator!=(const Date &lhs, const Date &rhs);
+        friend bool operator!=(const Date &lhs, const Date &rhs) { return lhs.day != rhs.day; }
 
-        friend bool operator<(const Date &lhs, const Date &rhs);
+        friend bool operator<(const Date &lhs, const Date &rhs) { return lhs.day < rhs.day; }
 
-        friend bool operator>(const Date &lhs, const Date &rhs);
+        friend bool operator>(const Date &lhs, const Date &rhs) { return lhs.day > rhs.day; }
 
-        friend bool operator<=(const Date &lhs, const Date &rhs);
+        friend bool operator<=(const Date &lhs, const Date &rhs) { return lhs.day <= rhs.day; }
 
-        friend bool operator>=(const Date &lhs, const Date &rhs);
+        friend bool operator>=(const Date &lhs, const Date &rhs) { return lhs.day >= rhs.day; }
 
-        friend int operator-(const Date &lhs, const Date &rhs);
+        friend int operator-(const Date &lhs, const Date &rhs) { return lhs.day - rhs.day; }
     };
 
+    // 时刻保存为从01-01 00:00起的分钟数，加减不回绕，跨年的时刻仍可比较和相减；
+    // date()按日期的规则回绕，例如12-31 23:00之后两小时的日期为01-01
+    // 由字符串或各字段构造非法时刻时抛出std::invalid_argument
     struct Time {
-        Date date;
-        int min;
-        int hour;
+        int minutes;
 
         Time() = default;
 
         Time(int min_, int hour_, int mday_ = 1, int mon_ = 1, int year_ = 1);
 
-        Time(const Time &o);
+        Time(const Time &o) = default;
 
         explicit Time(const char *str);
 
         ~Time() = default;
 
+        Date date() const { return Date::ofDay(floorMod(dayCount(), DAYS_PER_YEAR)); }
+
+        int hour() const { return floorMod(minutes, MINUTES_PER_DAY) / 60; }
+
+        int min() const { return floorMod(minutes, 60); }
+
         operator std::string() const;
 
         friend std::ostream &operator<<(std::ostream &os, const Time &time);
 
-        Time &operator+=(int mins);
+        Time &operator+=(int mins) {
+            minutes += mins;
+            return *this;
+        }
+
+        Time &operator-=(int mins) {
+            minutes -= mins;
+            return *this;
+        }
 
-        Time &operator-=(int mins);
+        Time operator+(int mins) const {
+            Time ret(*this);
+            ret.minutes += mins;
+            return ret;
+        }
 
-        Time operator+(int mins) const;
+        Time operator-(int mins) const {
+            Time ret(*this);
+            ret.minutes -= mins;
+            return ret;
+        }
 
-        Time operator-(int mins) const;
+        friend bool operator==(const Time &lhs, const Time &rhs) { return lhs.minutes == rhs.minutes; }
 
-        friend bool operator==(const Time &lhs, const Time &rhs);
+        friend bool operator!=(const Time &lhs, const Time &rhs) { return lhs.minutes != rhs.minutes; }
 
-        friend bool operator!=(const Time &lhs, const Time &rhs);
+        friend bool operator<(const Time &lhs, const Time &rhs) { return lhs.minutes < rhs.minutes; }
 
-        friend bool operator<(const Time &lhs, const Time &rhs);
+        friend bool operator>(const Time &lhs, const Time &rhs) { return lhs.minutes > rhs.minutes; }
 
-        friend bool operator>(const Time &lhs, const Time &rhs);
+        friend bool operator<=(const Time &lhs, const Time &rhs) { return lhs.minutes <= rhs.minutes; }
 
-        friend bool operator<=(const Time &lhs, const Time &rhs);
+        friend bool operator>=(const Time &lhs, const Time &rhs) { return lhs.minutes >= rhs.minutes; }
 
-        friend bool operator>=(const Time &lhs, const Time &rhs);
+        friend int operator-(const Time &lhs, const Time &rhs) { return lhs.minutes - rhs.minutes; }
 
-        friend int operator-(const Time &lhs, const Time &rhs);
+    private:
+        // 从01-01起经过的整天数，01-01之前为负数
+        int dayCount() const { return (minutes - floorMod(minutes, MINUTES_PER_DAY)) / MINUTES_PER_DAY; }
     };
 } // namespace trainsys
 
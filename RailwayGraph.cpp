@@ -35,4 +35,21 @@ namespace trainsys {
     void RailwayGraph::shortestPath(StationID departureStationID, StationID arrivalStationID, int type) {
         /* Question */
     }
+
+    // 删除与站点相连的所有区段；并查集不支持拆分，按剩下的区段重新合并
+    void RailwayGraph::removeStation(StationID stationID) {
+        for (int u = 0; u < routeGraph.numOfVer(); ++u) {
+            if (u == stationID) {
+                while (routeGraph.verList[u] != nullptr) routeGraph.remove(u, routeGraph.verList[u]->end);
+            } else {
+                while (routeGraph.exist(u, stationID)) routeGraph.remove(u, stationID);
+            }
+        }
+        stationSet.clear();
+        for (int u = 0; u < routeGraph.numOfVer(); ++u) {
+            for (GraphType::edgeNode *p = routeGraph.verList[u]; p != nullptr; p = p->next) {
+                stationSet.join(stationSet.find(u), stationSet.find(p->end));
+            }
+        }
+    }
 }
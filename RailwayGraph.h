@@ -33,6 +33,8 @@ namespace trainsys {
 
         void shortestPath(StationID departureStationID, StationID arrivalStationID, int type);
 
+        void removeStation(StationID stationID);
+
     private:
         void routeDfs(int curIdx, int arrivalIdx, seqList<StationID> &prevStations, bool *visited);
     };
@@ -1,17 +1,141 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
 #include "SchedulerManager.h"
+#include "DataStructure/DeltaCodec.h"
+#include "DataStructure/FileSync.h"
 
 
 namespace trainsys {
+    namespace {
+        // 版本1之前B+树中直接存放的调度信息，只用于迁移
+        struct LegacyTrainScheduler {
+            TrainID trainID;
+            int seatNum;
+            int passingStationNum;
+            StationID stations[MAX_PASSING_STATION_NUMBER];
+            int duration[MAX_PASSING_STATION_NUMBER];
+            int price[MAX_PASSING_STATION_NUMBER];
+
+            TrainScheduler upgrade() const {
+                if (passingStationNum < 0 || passingStationNum > MAX_PASSING_STATION_NUMBER) {
+                    throw std::runtime_error("Corrupted scheduler record");
+                }
+                TrainScheduler scheduler;
+                scheduler.setTrainID(trainID);
+                scheduler.setSeatNumber(seatNum);
+                for (int i = 0; i < passingStationNum; i++) {
+                    scheduler.addStation(stations[i]);
+                }
+                scheduler.setDuration(duration);
+                scheduler.setPrice(price);
+                return scheduler;
+            }
+
+            // 只为满足B+树的接口，每个车次只有一条记录
+            bool operator ==(const LegacyTrainScheduler &rhs) const { return trainID == rhs.trainID; }
+
+            bool operator <(const LegacyTrainScheduler &rhs) const { return trainID < rhs.trainID; }
+        };
+
+        int readLegacyVarint(const char *&p, const char *end) {
+            unsigned value;
+            int length = varintDecode(p, end, value);
+            if (length == 0) {
+                throw std::runtime_error("Corrupted scheduler record");
+            }
+            p += length;
+            return zigzagDecode(value);
+        }
+
+        // 版本1的记录：车次名之后的座位数、站点数、各站点与前一站ID之差、各段运行时间、各段票价都是zigzag变长整数
+        TrainScheduler decodeLegacyRecord(const char *data, int length) {
+            const char *end = data + length;
+            if (length < 2 || data[0] != 1 || static_cast<unsigned char>(data[1]) >= MAX_STRING_LENGTH
+                || length < 2 + static_cast<unsigned char>(data[1])) {
+                throw std::runtime_error("Corrupted scheduler record");
+            }
+            char name[MAX_STRING_LENGTH] = {};
+            memcpy(name, data + 2, static_cast<unsigned char>(data[1]));
+            const char *p = data + 2 + static_cast<unsigned char>(data[1]);
+            TrainScheduler scheduler;
+            scheduler.setTrainID(TrainID(name));
+            scheduler.setSeatNumber(readLegacyVarint(p, end));
+            int passingStationNum = readLegacyVarint(p, end);
+            if (passingStationNum < 0 || passingStationNum > MAX_PASSING_STATION_NUMBER) {
+                throw std::runtime_error("Corrupted scheduler record");
+            }
+            unsigned station = 0;
+            for (int i = 0; i < passingStationNum; i++) {
+                station += static_cast<unsigned>(readLegacyVarint(p, end));
+                scheduler.addStation(static_cast<StationID>(station));
+            }
+            int duration[MAX_PASSING_STATION_NUMBER] = {}, price[MAX_PASSING_STATION_NUMBER] = {};
+            for (int i = 0; i + 1 < passingStationNum; i++) {
+                duration[i] = readLegacyVarint(p, end);
+            }
+            for (int i = 0; i + 1 < passingStationNum; i++) {
+                price[i] = readLegacyVarint(p, end);
+            }
+            if (p != end) {
+                throw std::runtime_error("Corrupted scheduler record");
+            }
+            scheduler.setDuration(duration);
+            scheduler.setPrice(price);
+            return scheduler;
+        }
+    }
+
+    const char SchedulerManager::RECORD_MAGIC[8] = {'T', 'S', 'S', 'C', 'H', 'E', 'D', '\0'};
+
     /**
      * @brief 构造函数，初始化调度管理器
      * @param filename 用于持久化存储的文件名
+     * @throw std::runtime_error 当记录文件的文件头不符或旧版本的记录损坏时抛出异常
      * @note 
-     * - 使用B+树作为底层存储结构
+     * - 使用B+树作为底层存储结构，记录本身存放在filename + "_records"中
+     * - 先完成或丢弃上次中途退出的重写，再把旧版本的数据转换成当前格式
      * - 如果文件已存在，将从文件中加载数据
      * - 如果文件不存在，将创建新文件
      */
     SchedulerManager::SchedulerManager(const std::string &filename)
-        : schedulerInfo(filename) {
+        : filename(filename), schedulerInfo(nullptr), recordName(filename + "_records"),
+          recordSize(sizeof(RecordFileHeader)), deadBytes(0) {
+        commitRewrite(filename);
+        upgradeFiles(filename);
+        std::ifstream fin(recordName, std::ios::in | std::ios::binary);
+        if (!fin.is_open()) {
+            std::ofstream fout(recordName, std::ios::out | std::ios::binary | std::ios::trunc);
+            fout.close();
+            writeHeader();
+        } else {
+            RecordFileHeader header = {};
+            if (!fin.read(reinterpret_cast<char *>(&header), sizeof(header))
+                || memcmp(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0 || header.version != RECORD_VERSION) {
+                throw std::runtime_error("Invalid scheduler records");
+            }
+            fin.seekg(0, std::ios::end);
+            recordSize = fin.tellg();
+            deadBytes = header.deadBytes;
+        }
+        schedulerInfo = new SlotTree(filename);
+    }
+
+    /**
+     * @brief 析构函数
+     * @note 旧记录超过记录文件的一半时重写记录文件；重写失败时保留原文件，下次仍可使用
+     */
+    SchedulerManager::~SchedulerManager() {
+        try {
+            if (deadBytes * 2 > recordSize) {
+                compact();
+            }
+            writeHeader();
+        } catch (const std::exception &) {
+        }
+        delete schedulerInfo;
     }
 
     /**
@@ -24,7 +148,7 @@ namespace trainsys {
      * @param price 站点间票价数组，price[i]表示从第i站到第i+1站的票价
      * @throw std::runtime_error 当站点数量超过最大限制时抛出异常（由TrainScheduler::addStation抛出）
      * @note 
-     * - 如果trainID已存在，新的调度信息将覆盖旧的信息
+     * - 如果trainID已存在，新的调度信息将覆盖旧的信息，旧记录留在记录文件中直到重写
      * - 调用者需确保stations、duration和price数组的长度正确
      * - duration和price数组的有效长度应为passingStationNumber-1
      */
@@ -61,8 +185,18 @@ namespace trainsys {
         scheduler.setDuration(duration);
         scheduler.setPrice(price);
         
-        // 将调度信息插入到B+树中
-        schedulerInfo.insert(trainID, scheduler);
+        // 编码后追加到记录文件，B+树中只存记录的位置
+        std::vector<char> buffer(TrainScheduler::serializedSizeBound(passingStationNumber));
+        SchedulerSlot slot = appendRecord(buffer.data(), scheduler.serialize(buffer.data()));
+        SchedulerSlot oldSlot;
+        if (schedulerInfo->updateFirst(trainID, [&](SchedulerSlot &value) {
+            oldSlot = value;
+            value = slot;
+        })) {
+            deadBytes += oldSlot.length;
+        } else {
+            schedulerInfo->insert(trainID, slot);
+        }
     }
 
     /**
@@ -75,22 +209,42 @@ namespace trainsys {
      */
     bool SchedulerManager::existScheduler(const TrainID &trainID) {
         // 使用B+树的contains方法检查是否存在
-        return schedulerInfo.contains(trainID);
+        return schedulerInfo->contains(trainID);
     }
 
     /**
      * @brief 获取指定列车的调度信息
      * @param trainID 要查询的列车ID
-     * @return 返回对应的TrainScheduler对象
-     * @throw 如果trainID不存在，行为未定义（可能返回默认构造的对象）
+     * @return 返回对应的TrainScheduler对象，如果trainID不存在则返回默认构造的对象
+     * @throw std::runtime_error 当记录的位置超出记录文件或记录损坏时抛出异常
      * @note 
      * - 调用此函数前应先使用existScheduler检查是否存在
      * - 返回的是对象的副本，对返回值的修改不会影响存储的数据
      * - 该操作的时间复杂度为O(log n)
      */
     TrainScheduler SchedulerManager::getScheduler(const TrainID &trainID) {
-        // 使用B+树的findFirst方法获取调度信息
-        return schedulerInfo.findFirst(trainID);
+        SchedulerSlot slot;
+        if (!findSlot(trainID, slot)) {
+            return TrainScheduler();
+        }
+        return TrainSchedulerView(mapRecord(slot), slot.length).toScheduler();
+    }
+
+    /**
+     * @brief 获取指定列车调度信息的只读视图
+     * @param trainID 要查询的列车ID
+     * @return 返回建立在记录文件映射上的视图
+     * @throw std::runtime_error 当trainID不存在或记录损坏时抛出异常
+     * @note 
+     * - 不复制记录，也不展开成TrainScheduler，适合只读取少数字段的场合
+     * - 视图在下一次addScheduler/removeScheduler之前有效
+     */
+    TrainSchedulerView SchedulerManager::viewScheduler(const TrainID &trainID) {
+        SchedulerSlot slot;
+        if (!findSlot(trainID, slot)) {
+            throw std::runtime_error("Scheduler not found");
+        }
+        return TrainSchedulerView(mapRecord(slot), slot.length);
     }
 
     /**
@@ -103,7 +257,223 @@ namespace trainsys {
      * - 删除操作可能触发B+树的重平衡
      */
     void SchedulerManager::removeScheduler(const TrainID &trainID) {
-        // 使用B+树的removeFirst方法删除调度信息
-        schedulerInfo.removeFirst(trainID);
+        SchedulerSlot slot;
+        if (!findSlot(trainID, slot)) {
+            return;
+        }
+        schedulerInfo->remove(trainID, slot);
+        deadBytes += slot.length;
+    }
+
+    /**
+     * @brief 检查是否有车次经过指定站点
+     * @param stationID 要检查的站点ID
+     * @return 存在经过该站点的车次时返回true
+     * @throw std::runtime_error 当某条记录的位置超出记录文件或记录损坏时抛出异常
+     * @note 
+     * - 按车次顺序逐条在记录上建立视图，找到第一个经过该站点的车次即停止
+     * - 该操作的时间复杂度为O(车次数 * log 站点数)
+     */
+    bool SchedulerManager::referencesStation(const StationID &stationID) {
+        bool found = false;
+        schedulerInfo->forEachEntry([this, &stationID, &found](const TrainID &, const SchedulerSlot &slot) {
+            found = TrainSchedulerView(mapRecord(slot), slot.length).findStation(stationID) >= 0;
+            return !found;
+        });
+        return found;
+    }
+
+    bool SchedulerManager::findSlot(const TrainID &trainID, SchedulerSlot &slot) {
+        return schedulerInfo->forEach(trainID, [&slot](const SchedulerSlot &value) { slot = value; }, 0, 1) > 0;
+    }
+
+    // 记录超出当前映射的范围时重新映射，之前建立的视图随之失效
+    // 位置先与记录文件的长度比较，损坏的位置不会参与加法而溢出
+    const char *SchedulerManager::mapRecord(const SchedulerSlot &slot) {
+        if (slot.offset < (long long) sizeof(RecordFileHeader) || slot.length < 0 || slot.offset > recordSize
+            || slot.length > recordSize - slot.offset) {
+            throw std::runtime_error("Invalid scheduler record");
+        }
+        if (slot.offset + slot.length > records.size() && !records.open(recordName.c_str())) {
+            throw std::runtime_error("Failed to map scheduler records");
+        }
+        if (slot.offset + slot.length > records.size()) {
+            throw std::runtime_error("Invalid scheduler record");
+        }
+        return records.data() + slot.offset;
+    }
+
+    // 先关闭映射再追加：有的平台不允许写入正被映射的文件
+    SchedulerManager::SchedulerSlot SchedulerManager::appendRecord(const char *data, int length) {
+        records.close();
+        std::ofstream fout(recordName, std::ios::out | std::ios::binary | std::ios::app);
+        fout.write(data, length);
+        fout.close();
+        if (!fout) {
+            throw std::runtime_error("Failed to write scheduler record");
+        }
+        SchedulerSlot slot = {recordSize, length};
+        recordSize += length;
+        return slot;
+    }
+
+    void SchedulerManager::writeHeader() {
+        RecordFileHeader header = {};
+        memcpy(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+        header.version = RECORD_VERSION;
+        header.deadBytes = deadBytes;
+        records.close();
+        std::fstream file(recordName, std::ios::in | std::ios::out | std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Failed to write scheduler records");
+        }
+    }
+
+    // 按车次顺序把仍在使用的记录和新位置写到临时的记录文件和B+树，写好提交标记后再替换；
+    // 替换前关闭B+树，替换后重新打开
+    void SchedulerManager::compact() {
+        std::vector<Pair<TrainID, SchedulerSlot> > entries;
+        schedulerInfo->forEachEntry([&entries](const TrainID &trainID, const SchedulerSlot &slot) {
+            entries.push_back(Pair<TrainID, SchedulerSlot>(trainID, slot));
+        });
+        stageRewrite(filename, entries, [this, &entries](int i) { return mapRecord(entries[i].second); });
+        delete schedulerInfo;
+        schedulerInfo = nullptr;
+        records.close();
+        commitRewrite(filename);
+        schedulerInfo = new SlotTree(filename);
+        recordSize = sizeof(RecordFileHeader);
+        for (const Pair<TrainID, SchedulerSlot> &entry : entries) {
+            recordSize += entry.second.length;
+        }
+        deadBytes = 0;
+    }
+
+    /**
+     * @brief 把旧版本的调度信息转换成当前格式
+     * @param filename 用于持久化存储的文件名
+     * @throw std::runtime_error 当记录文件的版本未知或旧记录损坏时抛出异常
+     * @note 
+     * - 只有B+树没有记录文件的是版本1之前的数据，B+树中直接存放定长的TrainScheduler
+     * - 记录文件头中的版本为1时，记录是全部用变长整数的旧编码，B+树的格式与当前相同
+     * - 转换后的数据和重写记录文件一样经stageRewrite和commitRewrite替换旧数据，中途崩溃时旧数据不受影响
+     */
+    void SchedulerManager::upgradeFiles(const std::string &filename) {
+        std::string recordName = filename + "_records";
+        std::vector<Pair<TrainID, SchedulerSlot> > entries;
+        std::vector<std::vector<char> > encoded;
+        auto encode = [&entries, &encoded](const TrainScheduler &scheduler) {
+            encoded.emplace_back(TrainScheduler::serializedSizeBound(scheduler.getPassingStationNum()));
+            int length = scheduler.serialize(encoded.back().data());
+            entries.push_back(Pair<TrainID, SchedulerSlot>(scheduler.getTrainID(), SchedulerSlot{0, length}));
+        };
+        std::ifstream fin(recordName, std::ios::in | std::ios::binary);
+        if (!fin.is_open()) {
+            if (!SlotTree::exists(filename)) {
+                return;
+            }
+            BPlusTree<TrainID, LegacyTrainScheduler> legacy(filename);
+            legacy.forEachEntry([&encode](const TrainID &, const LegacyTrainScheduler &scheduler) {
+                encode(scheduler.upgrade());
+            });
+        } else {
+            RecordFileHeader header = {};
+            if (!fin.read(reinterpret_cast<char *>(&header), sizeof(header))
+                || memcmp(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0) {
+                throw std::runtime_error("Invalid scheduler records");
+            }
+            if (header.version == RECORD_VERSION) {
+                return;
+            }
+            if (header.version != 1) {
+                throw std::runtime_error("Unsupported scheduler records version");
+            }
+            fin.seekg(0, std::ios::end);
+            std::vector<char> data(fin.tellg());
+            fin.seekg(0);
+            fin.read(data.data(), data.size());
+            SlotTree slots(filename);
+            slots.forEachEntry([&encode, &data](const TrainID &, const SchedulerSlot &slot) {
+                if (slot.offset < (long long) sizeof(RecordFileHeader) || slot.length < 0
+                    || slot.offset > (long long) data.size() || slot.length > (long long) data.size() - slot.offset) {
+                    throw std::runtime_error("Invalid scheduler record");
+                }
+                encode(decodeLegacyRecord(data.data() + slot.offset, slot.length));
+            });
+        }
+        fin.close();
+        stageRewrite(filename, entries, [&encoded](int i) { return encoded[i].data(); });
+        commitRewrite(filename);
+    }
+
+    /**
+     * @brief 把entries中的记录写到新的记录文件和新的B+树，写完后建立提交标记
+     * @param entries 按车次升序排列，record(i)为第i条记录的数据，长度为entries[i].second.length；写出后改为新位置
+     * @note 
+     * - 新的记录文件为filename + "_records.tmp"，新的B+树为filename + "_rewrite"，都刷盘后才建立提交标记
+     *   filename + "_rewrite.commit"；标记存在时由commitRewrite替换旧数据
+     * - 只读取旧数据，调用前后旧的记录文件和B+树都可以继续使用
+     */
+    template<class Source>
+    void SchedulerManager::stageRewrite(const std::string &filename,
+                                        std::vector<Pair<TrainID, SchedulerSlot> > &entries, Source record) {
+        RecordFileHeader header = {};
+        memcpy(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+        header.version = RECORD_VERSION;
+        std::string tmpName = filename + "_records.tmp", treeName = filename + "_rewrite";
+        std::ofstream fout(tmpName, std::ios::out | std::ios::binary | std::ios::trunc);
+        fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        long long offset = sizeof(header);
+        for (int i = 0; i < (int) entries.size(); i++) {
+            fout.write(record(i), entries[i].second.length);
+            entries[i].second.offset = offset;
+            offset += entries[i].second.length;
+        }
+        fout.close();
+        if (!fout || !syncFile(tmpName.c_str())) {
+            throw std::runtime_error("Failed to write scheduler records");
+        }
+        SlotTree::destroy(treeName);
+        {
+            SlotTree tree(treeName);
+            tree.bulkLoad(entries.data(), entries.size());
+        }
+        SlotTree::sync(treeName);
+        std::string commitName = treeName + ".commit";
+        std::ofstream commit(commitName, std::ios::out | std::ios::trunc);
+        commit.close();
+        if (!commit || !syncFile(commitName.c_str()) || !syncDirectoryOf(commitName)) {
+            throw std::runtime_error("Failed to write scheduler records");
+        }
+    }
+
+    /**
+     * @brief 完成或丢弃stageRewrite写出的新数据
+     * @param filename 用于持久化存储的文件名，旧的B+树不能处于打开状态
+     * @note 
+     * - 有提交标记时先把新的记录文件改名覆盖旧文件，再把新的B+树逐个文件改名覆盖旧树，都落盘后删除标记；
+     *   中途崩溃后重新调用只改名剩下的文件，记录文件与B+树中的位置不会错配
+     * - 没有提交标记时新数据不完整，直接删除
+     */
+    void SchedulerManager::commitRewrite(const std::string &filename) {
+        std::string recordName = filename + "_records", tmpName = recordName + ".tmp";
+        std::string treeName = filename + "_rewrite", commitName = treeName + ".commit";
+        std::error_code error;
+        if (!std::filesystem::exists(commitName, error)) {
+            std::remove(tmpName.c_str());
+            SlotTree::destroy(treeName);
+            return;
+        }
+        if (std::filesystem::exists(tmpName, error)) {
+            std::filesystem::rename(tmpName, recordName);
+        }
+        SlotTree::rename(treeName, filename);
+        if (!syncDirectoryOf(filename)) {
+            throw std::runtime_error("Failed to write scheduler records");
+        }
+        std::remove(commitName.c_str());
+        syncDirectoryOf(filename);
     }
 }
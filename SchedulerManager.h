@@ -1,21 +1,51 @@
 #ifndef SCHEDULER_MANAGER_H
 #define SCHEDULER_MANAGER_H
 
+#include <string>
+#include <vector>
 #include "Utils.h"
 #include "TrainScheduler.h"
 #include "DataStructure/BPlusTree.h"
+#include "DataStructure/MappedFile.h"
 
 
 namespace trainsys {
+    // 调度信息按TrainScheduler::serialize的紧凑格式依次追加到记录文件（文件名 + "_records"），
+    // B+树只存每个车次的记录在文件中的位置。读取时映射记录文件，直接在映射上建立视图
+    // 覆盖和删除留下的旧记录只计数，析构时若超过文件的一半则重写记录文件
+    // 记录文件头中的版本不是当前版本时，构造时把所有记录转换成当前格式；只有B+树没有记录文件的是
+    // 版本1之前的数据，B+树中直接存放定长的TrainScheduler
     class SchedulerManager {
     private:
-        BPlusTree<TrainID, TrainScheduler> schedulerInfo;
+        struct SchedulerSlot {
+            long long offset;
+            int length;
+        };
+
+        typedef BPlusTree<TrainID, SchedulerSlot, 100, 100, true> SlotTree;
+
+        // 记录文件的文件头，其后是各条记录
+        struct RecordFileHeader {
+            char magic[8];
+            int version;
+            int reserved;
+            long long deadBytes;
+        };
+
+        static const char RECORD_MAGIC[8];
+        static const int RECORD_VERSION = 2;
+
+        std::string filename;
+        SlotTree *schedulerInfo; // 每个车次一条记录；重写记录文件时关闭后重新打开
+        std::string recordName;
+        MappedFile records; // 第一次读取时映射，追加记录前关闭
+        long long recordSize; // 记录文件的长度
+        long long deadBytes; // 已被覆盖或删除的记录的总长度
 
     public:
         SchedulerManager(const std::string &filename);
 
-        ~SchedulerManager() {
-        }
+        ~SchedulerManager();
 
         void addScheduler(const TrainID &trainID, int seatNum,
                           int passingStationNumber, const StationID *stations, const int *duration, const int *price);
@@ -24,7 +54,32 @@ namespace trainsys {
 
         TrainScheduler getScheduler(const TrainID &trainID);
 
+        // 不复制、不展开地读取调度信息，视图在下一次addScheduler/removeScheduler之前有效
+        TrainSchedulerView viewScheduler(const TrainID &trainID);
+
         void removeScheduler(const TrainID &trainID);
+
+        // 是否有车次经过该站点，逐条检查所有调度信息，只在删除站点等不频繁的操作中使用
+        bool referencesStation(const StationID &stationID);
+
+    private:
+        bool findSlot(const TrainID &trainID, SchedulerSlot &slot);
+
+        const char *mapRecord(const SchedulerSlot &slot);
+
+        SchedulerSlot appendRecord(const char *data, int length);
+
+        void writeHeader();
+
+        void compact();
+
+        static void upgradeFiles(const std::string &filename);
+
+        template<class Source>
+        static void stageRewrite(const std::string &filename, std::vector<Pair<TrainID, SchedulerSlot> > &entries,
+                                 Source record);
+
+        static void commitRewrite(const std::string &filename);
     };
 }
 
@@ -0,0 +1,100 @@
+#ifndef SEAT_BITMAP_H_
+#define SEAT_BITMAP_H_
+
+#include <cstdint>
+#include "Utils.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace trainsys {
+    // 座位图按每64个座位一块存放，键为车次、日期和块号
+    struct SeatBlockKey {
+        TrainID trainID;
+        Date date;
+        int block;
+
+        SeatBlockKey() = default;
+
+        SeatBlockKey(const TrainID &trainID, const Date &date, int block) : trainID(trainID), date(date), block(block) {
+        }
+
+        friend bool operator==(const SeatBlockKey &lhs, const SeatBlockKey &rhs) {
+            return lhs.block == rhs.block && lhs.date == rhs.date && lhs.trainID == rhs.trainID;
+        }
+
+        friend bool operator!=(const SeatBlockKey &lhs, const SeatBlockKey &rhs) {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const SeatBlockKey &lhs, const SeatBlockKey &rhs) {
+            int cmp = strcmp(lhs.trainID.index, rhs.trainID.index);
+            if (cmp != 0) return cmp < 0;
+            if (lhs.date != rhs.date) return lhs.date < rhs.date;
+            return lhs.block < rhs.block;
+        }
+    };
+
+    // 64个座位的占用情况，每个座位一个64位字，第i位为1表示第i站到第i+1站这一段已售出
+    // 找[i, j)上的空座即找与segmentMask(i, j)按位与为0的字；编译时启用AVX2则一次比较4个座位
+    struct SeatBlock {
+        static const int SEATS_PER_BLOCK = 64;
+        static_assert(MAX_PASSING_STATION_NUMBER - 1 <= 64, "too many segments");
+
+        alignas(32) uint64_t seats[SEATS_PER_BLOCK];
+
+        SeatBlock() = default;
+
+        // 前seatCount个座位为空，其余座位不存在，标记为全部售出
+        explicit SeatBlock(int seatCount) {
+            for (int i = 0; i < SEATS_PER_BLOCK; ++i) seats[i] = i < seatCount ? 0 : ~0ULL;
+        }
+
+        static uint64_t segmentMask(int l, int r) {
+            uint64_t high = r >= 64 ? ~0ULL : (1ULL << r) - 1;
+            return high & ~((1ULL << l) - 1);
+        }
+
+        // 第一个在mask各段上都空闲的座位，没有时返回-1
+        int findFree(uint64_t mask) const {
+#if defined(__AVX2__)
+            const __m256i m = _mm256_set1_epi64x(static_cast<long long>(mask));
+            const __m256i zero = _mm256_setzero_si256();
+            for (int i = 0; i < SEATS_PER_BLOCK; i += 4) {
+                __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(seats + i));
+                __m256i free = _mm256_cmpeq_epi64(_mm256_and_si256(v, m), zero);
+                int bits = _mm256_movemask_pd(_mm256_castsi256_pd(free));
+                if (bits) return i + __builtin_ctz(bits);
+            }
+            return -1;
+#else
+            for (int i = 0; i < SEATS_PER_BLOCK; ++i) {
+                if ((seats[i] & mask) == 0) return i;
+            }
+            return -1;
+#endif
+        }
+
+        // 在mask各段上都空闲的座位数
+        int countFree(uint64_t mask) const {
+#if defined(__AVX2__)
+            const __m256i m = _mm256_set1_epi64x(static_cast<long long>(mask));
+            const __m256i zero = _mm256_setzero_si256();
+            int count = 0;
+            for (int i = 0; i < SEATS_PER_BLOCK; i += 4) {
+                __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(seats + i));
+                __m256i free = _mm256_cmpeq_epi64(_mm256_and_si256(v, m), zero);
+                count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(free)));
+            }
+            return count;
+#else
+            int count = 0;
+            for (int i = 0; i < SEATS_PER_BLOCK; ++i) count += (seats[i] & mask) == 0;
+            return count;
+#endif
+        }
+    };
+}
+
+#endif // SEAT_BITMAP_H_
@@ -0,0 +1,147 @@
+#ifndef SEAT_INVENTORY_H_
+#define SEAT_INVENTORY_H_
+
+#include <atomic>
+#include "Utils.h"
+
+namespace trainsys {
+    // 车次某一天的键
+    struct TrainDayKey {
+        TrainID trainID;
+        Date date;
+
+        TrainDayKey() = default;
+
+        TrainDayKey(const TrainID &trainID, const Date &date) : trainID(trainID), date(date) {
+        }
+
+        friend bool operator==(const TrainDayKey &lhs, const TrainDayKey &rhs) {
+            return lhs.date == rhs.date && lhs.trainID == rhs.trainID;
+        }
+
+        friend bool operator!=(const TrainDayKey &lhs, const TrainDayKey &rhs) {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const TrainDayKey &lhs, const TrainDayKey &rhs) {
+            int cmp = strcmp(lhs.trainID.index, rhs.trainID.index);
+            if (cmp != 0) return cmp < 0;
+            return lhs.date < rhs.date;
+        }
+
+        friend bool operator>(const TrainDayKey &lhs, const TrainDayKey &rhs) {
+            return rhs < lhs;
+        }
+    };
+
+    // 支持区间加、区间最小值的线段树，第i个叶子为第i站到第i+1站这一段的余票
+    // Cell为int时用于写入磁盘的SeatInventory；为std::atomic<int>时用于内存中在seqlock下读写的余票记录，
+    // 各结点按relaxed次序读写，一致性由记录的版本号保证
+    template<class Cell>
+    struct SeatSegmentTree {
+        static const int SEGMENT_CAPACITY = 32; // 叶子数，不小于最大区间数
+        static_assert(SEGMENT_CAPACITY >= MAX_PASSING_STATION_NUMBER - 1, "too many segments");
+
+        Cell minSeat[2 * SEGMENT_CAPACITY]; // 子树的最小余票，已包含本结点及子树中的pending
+        Cell pending[2 * SEGMENT_CAPACITY]; // 作用于整个子树、尚未下传的增量
+
+        // 所有区间的余票都为seatNum
+        void fill(int seatNum) {
+            for (int i = 0; i < 2 * SEGMENT_CAPACITY; ++i) set(minSeat[i], seatNum), set(pending[i], 0);
+        }
+
+        // 第i个区间的余票为seats[i]，segmentCount之后的区间视为余票无穷多
+        void assign(const int *seats, int segmentCount) {
+            for (int i = 0; i < SEGMENT_CAPACITY; ++i) {
+                set(minSeat[SEGMENT_CAPACITY + i], i < segmentCount ? seats[i] : 0x7fffffff);
+            }
+            for (int i = SEGMENT_CAPACITY - 1; i > 0; --i) {
+                int left = get(minSeat[2 * i]), right = get(minSeat[2 * i + 1]);
+                set(minSeat[i], left < right ? left : right);
+            }
+            for (int i = 0; i < 2 * SEGMENT_CAPACITY; ++i) set(pending[i], 0);
+        }
+
+        // 逐个结点复制另一棵树，两棵树的Cell可以不同
+        template<class OtherCell>
+        void copyFrom(const SeatSegmentTree<OtherCell> &other) {
+            for (int i = 0; i < 2 * SEGMENT_CAPACITY; ++i) {
+                set(minSeat[i], get(other.minSeat[i]));
+                set(pending[i], get(other.pending[i]));
+            }
+        }
+
+        // 区间[l, r)中的最小余票，即从第l站到第r站能买到的票数
+        int query(int l, int r) const {
+            return query(1, 0, SEGMENT_CAPACITY, l, r);
+        }
+
+        // 区间[l, r)的余票都加上delta
+        void add(int l, int r, int delta) {
+            add(1, 0, SEGMENT_CAPACITY, l, r, delta);
+        }
+
+        static int get(const int &cell) { return cell; }
+
+        static int get(const std::atomic<int> &cell) { return cell.load(std::memory_order_relaxed); }
+
+        static void set(int &cell, int value) { cell = value; }
+
+        static void set(std::atomic<int> &cell, int value) { cell.store(value, std::memory_order_relaxed); }
+
+    private:
+        int query(int node, int nodeL, int nodeR, int l, int r) const {
+            if (l <= nodeL && nodeR <= r) return get(minSeat[node]);
+            int mid = (nodeL + nodeR) / 2, ans = 0x7fffffff;
+            if (l < mid) ans = query(node * 2, nodeL, mid, l, r);
+            if (r > mid) {
+                int right = query(node * 2 + 1, mid, nodeR, l, r);
+                if (right < ans) ans = right;
+            }
+            return ans + get(pending[node]);
+        }
+
+        void add(int node, int nodeL, int nodeR, int l, int r, int delta) {
+            if (l <= nodeL && nodeR <= r) {
+                set(minSeat[node], get(minSeat[node]) + delta), set(pending[node], get(pending[node]) + delta);
+                return;
+            }
+            int mid = (nodeL + nodeR) / 2;
+            if (l < mid) add(node * 2, nodeL, mid, l, r, delta);
+            if (r > mid) add(node * 2 + 1, mid, nodeR, l, r, delta);
+            int left = get(minSeat[node * 2]), right = get(minSeat[node * 2 + 1]);
+            set(minSeat[node], (left < right ? left : right) + get(pending[node]));
+        }
+    };
+
+    // 车次某一天各区间的余票，用线段树存放在一条定长记录里：查询和预订[i, j)都是O(log 站数)，
+    // 整条记录在B+树的叶子中就地修改，一次预订只写一页
+    struct SeatInventory {
+        int stationNum;
+        StationID stations[MAX_PASSING_STATION_NUMBER];
+        SeatSegmentTree<int> seats;
+
+        SeatInventory() = default;
+
+        SeatInventory(const StationID *stations_, int stationNum_, int seatNum) : stationNum(stationNum_) {
+            for (int i = 0; i < stationNum; ++i) stations[i] = stations_[i];
+            seats.fill(seatNum);
+        }
+
+        // 第i个区间的余票为seats_[i]
+        SeatInventory(const StationID *stations_, int stationNum_, const int *seats_) : stationNum(stationNum_) {
+            for (int i = 0; i < stationNum; ++i) stations[i] = stations_[i];
+            seats.assign(seats_, stationNum - 1);
+        }
+
+        int query(int l, int r) const {
+            return seats.query(l, r);
+        }
+
+        void add(int l, int r, int delta) {
+            seats.add(l, r, delta);
+        }
+    };
+}
+
+#endif // SEAT_INVENTORY_H_
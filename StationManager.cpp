@@ -1,31 +1,319 @@
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <string>
+#include <stdexcept>
 #include "StationManager.h"
+#include "DataStructure/FileSync.h"
 
 namespace trainsys {
-    StationManager::StationManager(const char *filename) {
-        std::ifstream fin;
-        fin.open(filename, std::ios::in);
+    const char StationManager::CATALOG_MAGIC[8] = {'T', 'S', 'S', 'T', 'A', 'T', 'N', '\0'};
+
+    StationManager::StationManager(const char *filename)
+        : catalogImage(nullptr), header(nullptr), nameOffset(nullptr), slotToID(nullptr), namePool(nullptr),
+          overlayCount(0), nameIndexBuilt(false) {
+        for (int i = 0; i < MAX_STATIONID; ++i) {
+            overridden[i] = false;
+            overlayNames[i][0] = '\0';
+            popularity[i] = 0;
+        }
+        journalName = std::string(filename) + ".journal";
+        char magic[sizeof(CATALOG_MAGIC)] = {};
+        std::ifstream fin(filename, std::ios::in | std::ios::binary);
         if (!fin.is_open()) {
             puts("station info not found");
-            return;
+        } else {
+            fin.read(magic, sizeof(magic));
+            fin.close();
+            if (memcmp(magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) == 0) {
+                if (!catalogFile.open(filename)) throw std::runtime_error("Failed to map station catalog");
+                attach(catalogFile.data(), catalogFile.size());
+                catalogName = filename;
+            } else {
+                puts("loading station info");
+                long long size;
+                catalogImage = buildCatalog(filename, size);
+                attach(catalogImage, size);
+            }
         }
-        char stationName[MAX_STATIONNAME_LEN + 1];
-        StationID stationID;
-        puts("loading station info");
-        while (fin >> stationName >> stationID) {
-            idToName.insertEntry(stationID, String(stationName));
-            nameToID.insertEntry(String(stationName), stationID);
+        replayJournal();
+    }
+
+    StationManager::~StationManager() {
+        // 合并失败时保留日志，下次启动仍能重放
+        try {
+            compact();
+        } catch (const std::exception &) {
         }
-        idToName.sortEntry();
-        nameToID.sortEntry();
+        delete[] catalogImage;
     }
 
     String StationManager::getStationName(const StationID &stationID) {
-        return idToName.find(stationID);
+        if (stationID < 0 || stationID >= MAX_STATIONID) return String();
+        if (overridden[stationID]) return String(overlayNames[stationID]);
+        const char *name = baseName(stationID);
+        return name == nullptr ? String() : String(name);
     }
 
     StationID StationManager::getStationID(const char *stationName) {
-        return nameToID.find(String(stationName));
+        StationID stationID = findStation(stationName);
+        if (stationID < 0) return StationID();
+        ++popularity[stationID];
+        if (nameIndexBuilt) nameIndex.addWeight(stationName, 1);
+        return stationID;
+    }
+
+    bool StationManager::existStation(const StationID &stationID) const {
+        if (stationID < 0 || stationID >= MAX_STATIONID) return false;
+        if (overridden[stationID]) return overlayNames[stationID][0] != '\0';
+        return baseName(stationID) != nullptr;
+    }
+
+    bool StationManager::existStationName(const char *stationName) const {
+        return findStation(stationName) >= 0;
+    }
+
+    void StationManager::addStation(const StationID &stationID, const char *stationName) {
+        if (stationID < 0 || stationID >= MAX_STATIONID || existStation(stationID)) {
+            throw std::invalid_argument("Invalid station id");
+        }
+        if (stationName[0] == '\0' || strlen(stationName) > MAX_STATIONNAME_LEN || existStationName(stationName)) {
+            throw std::invalid_argument("Invalid station name");
+        }
+        setStation(stationID, stationName);
+        journalStream() << "A " << stationID << ' ' << stationName << std::endl;
+    }
+
+    void StationManager::renameStation(const StationID &stationID, const char *newName) {
+        if (!existStation(stationID)) throw std::invalid_argument("Invalid station id");
+        if (newName[0] == '\0' || strlen(newName) > MAX_STATIONNAME_LEN || existStationName(newName)) {
+            throw std::invalid_argument("Invalid station name");
+        }
+        setStation(stationID, newName);
+        journalStream() << "A " << stationID << ' ' << newName << std::endl;
+    }
+
+    void StationManager::removeStation(const StationID &stationID) {
+        if (!existStation(stationID)) throw std::invalid_argument("Invalid station id");
+        setStation(stationID, "");
+        journalStream() << "D " << stationID << std::endl;
+    }
+
+    int StationManager::completeStationName(const char *prefix, StationID *result, int k) {
+        if (!nameIndexBuilt) buildNameIndex();
+        return nameIndex.complete(prefix, result, k);
+    }
+
+    int StationManager::fuzzyFindStation(const char *stationName, int maxDistance, StationID *result, int k) {
+        if (!nameIndexBuilt) buildNameIndex();
+        return nameIndex.fuzzyFind(stationName, maxDistance, result, k);
+    }
+
+    bool StationManager::compileCatalog(const char *textFile, const char *catalogFile) {
+        long long size;
+        char *image = buildCatalog(textFile, size);
+        if (image == nullptr) return false;
+        try {
+            writeCatalog(image, size, catalogFile);
+        } catch (...) {
+            delete[] image;
+            throw;
+        }
+        delete[] image;
+        return true;
+    }
+
+    char *StationManager::buildCatalog(const char *textFile, long long &size) {
+        std::ifstream fin(textFile, std::ios::in);
+        if (!fin.is_open()) return nullptr;
+        int nameStart[MAX_STATIONID];
+        StationID ids[MAX_STATIONID];
+        std::string pool, stationName;
+        StationID stationID;
+        int stationCount = 0;
+        for (int i = 0; i < MAX_STATIONID; ++i) nameStart[i] = -1;
+        while (fin >> stationName >> stationID) {
+            if (stationName.length() > MAX_STATIONNAME_LEN) throw std::runtime_error("Station name too long");
+            if (stationID < 0 || stationID >= MAX_STATIONID || nameStart[stationID] >= 0) {
+                throw std::runtime_error("Invalid station id");
+            }
+            nameStart[stationID] = pool.length();
+            pool.append(stationName.c_str(), stationName.length() + 1);
+            ids[stationCount++] = stationID;
+        }
+        const char *names[MAX_STATIONID];
+        for (int i = 0; i < stationCount; ++i) names[i] = pool.c_str() + nameStart[ids[i]];
+        return buildImage(names, ids, stationCount, size);
+    }
+
+    char *StationManager::buildImage(const char *const *names, const StationID *ids, int stationCount,
+                                     long long &size) {
+        PerfectHash hash;
+        hash.build(names, stationCount);
+        int nameStart[MAX_STATIONID];
+        for (int i = 0; i < MAX_STATIONID; ++i) nameStart[i] = -1;
+        int poolSize = 0;
+        for (int i = 0; i < stationCount; ++i) {
+            nameStart[ids[i]] = poolSize;
+            poolSize += strlen(names[i]) + 1;
+        }
+
+        CatalogHeader catalogHeader = {};
+        memcpy(catalogHeader.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+        catalogHeader.version = CATALOG_VERSION;
+        catalogHeader.stationCount = stationCount;
+        catalogHeader.idCapacity = MAX_STATIONID;
+        catalogHeader.bucketCount = hash.getBucketCount();
+        catalogHeader.seed = hash.getSeed();
+        catalogHeader.namePoolSize = poolSize;
+
+        size = sizeof(CatalogHeader) + sizeof(int) * MAX_STATIONID + sizeof(StationID) * stationCount
+               + sizeof(int) * catalogHeader.bucketCount + poolSize;
+        char *image = new char[size];
+        char *p = image;
+        memcpy(p, &catalogHeader, sizeof(CatalogHeader));
+        p += sizeof(CatalogHeader);
+        memcpy(p, nameStart, sizeof(int) * MAX_STATIONID);
+        p += sizeof(int) * MAX_STATIONID;
+        StationID *slots = reinterpret_cast<StationID *>(p);
+        for (int i = 0; i < stationCount; ++i) slots[hash(names[i])] = ids[i];
+        p += sizeof(StationID) * stationCount;
+        if (catalogHeader.bucketCount > 0) memcpy(p, hash.getDisplacement(), sizeof(int) * catalogHeader.bucketCount);
+        p += sizeof(int) * catalogHeader.bucketCount;
+        for (int i = 0; i < stationCount; ++i) strcpy(p + nameStart[ids[i]], names[i]);
+        return image;
+    }
+
+    // 先写临时文件并刷盘，再改名覆盖旧目录并刷写所在目录；中途崩溃时catalogFile要么是完整的旧目录，要么是完整的新目录
+    void StationManager::writeCatalog(const char *image, long long size, const char *catalogFile) {
+        std::string tmpFile = std::string(catalogFile) + ".tmp";
+        std::ofstream fout(tmpFile, std::ios::out | std::ios::binary | std::ios::trunc);
+        fout.write(image, size);
+        fout.close();
+        if (!fout || !syncFile(tmpFile.c_str())) throw std::runtime_error("Failed to write station catalog");
+        std::error_code error;
+        std::filesystem::rename(tmpFile, catalogFile, error);
+        if (error || !syncDirectoryOf(catalogFile)) throw std::runtime_error("Failed to write station catalog");
+    }
+
+    // 只检查文件头和各段长度，不扫描内容，因此打开目录的时间与站点数量无关
+    void StationManager::attach(const char *image, long long size) {
+        const CatalogHeader *h = reinterpret_cast<const CatalogHeader *>(image);
+        if (size < (long long) sizeof(CatalogHeader) || memcmp(h->magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0
+            || h->version != CATALOG_VERSION) {
+            throw std::runtime_error("Invalid station catalog");
+        }
+        if (h->stationCount < 0 || h->idCapacity < 0 || h->idCapacity > MAX_STATIONID || h->bucketCount < 0
+            || h->namePoolSize < 0
+            || size != (long long) sizeof(CatalogHeader) + (long long) sizeof(int) * h->idCapacity
+                       + (long long) sizeof(StationID) * h->stationCount + (long long) sizeof(int) * h->bucketCount
+                       + h->namePoolSize) {
+            throw std::runtime_error("Invalid station catalog");
+        }
+        header = h;
+        nameOffset = reinterpret_cast<const int *>(image + sizeof(CatalogHeader));
+        slotToID = reinterpret_cast<const StationID *>(nameOffset + h->idCapacity);
+        const int *displacement = reinterpret_cast<const int *>(slotToID + h->stationCount);
+        namePool = reinterpret_cast<const char *>(displacement + h->bucketCount);
+        nameHash.attach(h->stationCount, h->bucketCount, h->seed, displacement);
+    }
+
+    const char *StationManager::baseName(StationID stationID) const {
+        if (header == nullptr || stationID >= header->idCapacity || nameOffset[stationID] < 0) return nullptr;
+        return namePool + nameOffset[stationID];
+    }
+
+    // 先查覆盖层，再查目录；目录中的站点若已被改名或删除则不算数。站名不存在时返回-1
+    StationID StationManager::findStation(const char *stationName) const {
+        if (strlen(stationName) > MAX_STATIONNAME_LEN) return -1;
+        if (overlayCount > 0) {
+            DataType<String, StationID> *entry = overlayIDs.find(String(stationName));
+            if (entry != nullptr) return entry->value;
+        }
+        int slot = nameHash(stationName);
+        if (slot < 0) return -1;
+        StationID stationID = slotToID[slot];
+        if (strcmp(namePool + nameOffset[stationID], stationName) != 0 || overridden[stationID]) return -1;
+        return stationID;
+    }
+
+    // 把站点的当前名字设为stationName，空串表示删除；重复执行结果不变，因此日志可以安全地重放
+    void StationManager::setStation(StationID stationID, const char *stationName) {
+        if (nameIndexBuilt) {
+            const char *oldName = overridden[stationID] ? overlayNames[stationID] : baseName(stationID);
+            if (oldName != nullptr && oldName[0] != '\0') nameIndex.remove(oldName);
+            if (stationName[0] != '\0') nameIndex.insert(stationName, stationID, popularity[stationID]);
+        }
+        if (stationName[0] == '\0') popularity[stationID] = 0;
+        if (overridden[stationID]) {
+            if (overlayNames[stationID][0] != '\0') overlayIDs.remove(String(overlayNames[stationID]));
+        } else {
+            overridden[stationID] = true;
+            ++overlayCount;
+        }
+        strcpy(overlayNames[stationID], stationName);
+        if (stationName[0] != '\0') overlayIDs.insert(DataType<String, StationID>(String(stationName), stationID));
+    }
+
+    void StationManager::replayJournal() {
+        std::ifstream fin(journalName, std::ios::in);
+        if (!fin.is_open()) return;
+        char op;
+        StationID stationID;
+        std::string stationName;
+        while (fin >> op >> stationID) {
+            if (stationID < 0 || stationID >= MAX_STATIONID) throw std::runtime_error("Invalid station journal");
+            if (op == 'A') {
+                if (!(fin >> stationName) || stationName.length() > MAX_STATIONNAME_LEN) {
+                    throw std::runtime_error("Invalid station journal");
+                }
+                setStation(stationID, stationName.c_str());
+            } else if (op == 'D') {
+                setStation(stationID, "");
+            } else {
+                throw std::runtime_error("Invalid station journal");
+            }
+        }
+    }
+
+    std::ofstream &StationManager::journalStream() {
+        if (!journal.is_open()) journal.open(journalName, std::ios::out | std::ios::app);
+        return journal;
+    }
+
+    // 把覆盖层合并进新的二进制目录，成功后清空日志；若在改名之后、清空日志之前中断，
+    // 下次启动会在新目录上再重放一遍日志，结果不变
+    void StationManager::compact() {
+        if (catalogName.empty() || overlayCount == 0) return;
+        const char *names[MAX_STATIONID];
+        StationID ids[MAX_STATIONID];
+        int stationCount = 0;
+        for (StationID i = 0; i < MAX_STATIONID; ++i) {
+            const char *name = overridden[i] ? overlayNames[i] : baseName(i);
+            if (name == nullptr || name[0] == '\0') continue;
+            names[stationCount] = name;
+            ids[stationCount++] = i;
+        }
+        long long size;
+        char *image = buildImage(names, ids, stationCount, size);
+        journal.close();
+        catalogFile.close();
+        header = nullptr;
+        try {
+            writeCatalog(image, size, catalogName.c_str());
+        } catch (...) {
+            delete[] image;
+            throw;
+        }
+        delete[] image;
+        std::ofstream clear(journalName, std::ios::out | std::ios::trunc);
+    }
+
+    void StationManager::buildNameIndex() {
+        for (StationID i = 0; i < MAX_STATIONID; ++i) {
+            const char *name = overridden[i] ? overlayNames[i] : baseName(i);
+            if (name != nullptr && name[0] != '\0') nameIndex.insert(name, i, popularity[i]);
+        }
+        nameIndexBuilt = true;
     }
 }
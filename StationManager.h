@@ -1,24 +1,115 @@
 #ifndef STATION_MANAGER_H_
 #define STATION_MANAGER_H_
 
+#include <fstream>
+#include <string>
 #include "Utils.h"
-#include "DataStructure/BinarySearchTable.h"
+#include "DataStructure/PerfectHash.h"
+#include "DataStructure/MappedFile.h"
+#include "DataStructure/EytzingerTable.h"
+#include "DataStructure/Trie.h"
 
 namespace trainsys {
+    // 站点目录：既可以读取文本格式的station.txt（每行“站名 站点ID”），
+    // 也可以直接映射由compileCatalog()生成的二进制目录，后者启动时不需要解析和建表
+    // 运行期间新增、改名、删除的站点记在覆盖层中，并追加写入日志文件（目录文件名 + ".journal"），
+    // 启动时在目录之上重放日志；从二进制目录启动时，析构时把覆盖层合并进新的目录并清空日志
     class StationManager {
     private:
-        BinarySearchTable<StationID, String> idToName;
-        BinarySearchTable<String, StationID> nameToID;
+        // 二进制目录的文件头，其后依次为：
+        // int nameOffset[idCapacity]     站点ID -> 站名在字符串池中的偏移，-1表示该ID不存在
+        // StationID slotToID[stationCount] 完美哈希位置 -> 站点ID
+        // int displacement[bucketCount]   完美哈希的位移表
+        // char namePool[namePoolSize]     以'\0'结尾的站名依次排列
+        struct CatalogHeader {
+            char magic[8];
+            int version;
+            int stationCount;
+            int idCapacity;
+            int bucketCount;
+            unsigned long long seed;
+            int namePoolSize;
+            int reserved;
+        };
+
+        static const char CATALOG_MAGIC[8];
+        static const int CATALOG_VERSION = 1;
+
+        MappedFile catalogFile;
+        std::string catalogName; // 从二进制目录启动时记录目录文件名，用于析构时合并
+        char *catalogImage; // 从文本格式加载时在内存中生成的目录
+        const CatalogHeader *header;
+        const int *nameOffset;
+        const StationID *slotToID;
+        const char *namePool;
+        PerfectHash nameHash;
+
+        // 覆盖层：overridden[id]为真时以overlayNames[id]为准，空串表示该站点已删除
+        bool overridden[MAX_STATIONID];
+        char overlayNames[MAX_STATIONID][MAX_STATIONNAME_LEN + 1];
+        EytzingerTable<String, StationID> overlayIDs; // 覆盖层很小且只在管理命令中修改
+        int overlayCount;
+        std::string journalName;
+        std::ofstream journal; // 第一次修改时才打开
+
+        // 站名的字典树，供前缀补全和模糊查找使用，第一次查询时才建立；热度为按站名查询站点ID的次数
+        Trie<StationID> nameIndex;
+        bool nameIndexBuilt;
+        long long popularity[MAX_STATIONID];
 
     public:
         StationManager(const char *filename);
 
-        ~StationManager() {
-        }
+        ~StationManager();
 
         String getStationName(const StationID &stationID);
 
         StationID getStationID(const char *stationName);
+
+        int getStationCount() const { return header == nullptr ? 0 : header->stationCount; }
+
+        bool existStation(const StationID &stationID) const;
+
+        bool existStationName(const char *stationName) const;
+
+        // 以下三个操作要求调用者已检查站点ID与站名的合法性，否则抛出std::invalid_argument
+        void addStation(const StationID &stationID, const char *stationName);
+
+        void renameStation(const StationID &stationID, const char *newName);
+
+        void removeStation(const StationID &stationID);
+
+        // 以prefix开头的站名中查询次数最多的至多k个站点，返回个数
+        int completeStationName(const char *prefix, StationID *result, int k);
+
+        // 与stationName编辑距离不超过maxDistance的至多k个站点，距离近的在前，返回个数
+        int fuzzyFindStation(const char *stationName, int maxDistance, StationID *result, int k);
+
+        // 把文本格式的站点信息编译成二进制目录，文本文件不存在时返回false
+        static bool compileCatalog(const char *textFile, const char *catalogFile);
+
+    private:
+        static char *buildCatalog(const char *textFile, long long &size);
+
+        static char *buildImage(const char *const *names, const StationID *ids, int stationCount, long long &size);
+
+        static void writeCatalog(const char *image, long long size, const char *catalogFile);
+
+        void attach(const char *image, long long size);
+
+        const char *baseName(StationID stationID) const;
+
+        StationID findStation(const char *stationName) const;
+
+        void setStation(StationID stationID, const char *stationName);
+
+        void replayJournal();
+
+        std::ofstream &journalStream();
+
+        void compact();
+
+        void buildNameIndex();
     };
 }
 
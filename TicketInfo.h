@@ -4,6 +4,35 @@
 #include "Utils.h"
 
 namespace trainsys {
+    // 车票的复合键，按车次、日期、出发站排序，同一车次同一天的车票在B+树中连续存放
+    // 各字段依次排列恰好没有填充字节
+    struct TicketKey {
+        TrainID trainID;
+        Date date;
+        StationID departureStation;
+
+        TicketKey() = default;
+
+        TicketKey(const TrainID &trainID, const Date &date, const StationID &departureStation)
+            : trainID(trainID), date(date), departureStation(departureStation) {
+        }
+
+        friend bool operator==(const TicketKey &lhs, const TicketKey &rhs) {
+            return lhs.departureStation == rhs.departureStation && lhs.date == rhs.date && lhs.trainID == rhs.trainID;
+        }
+
+        friend bool operator!=(const TicketKey &lhs, const TicketKey &rhs) {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const TicketKey &lhs, const TicketKey &rhs) {
+            int cmp = strcmp(lhs.trainID.index, rhs.trainID.index);
+            if (cmp != 0) return cmp < 0;
+            if (lhs.date != rhs.date) return lhs.date < rhs.date;
+            return lhs.departureStation < rhs.departureStation;
+        }
+    };
+
     struct TicketInfo {
         TrainID trainID;
         StationID departureStation;
@@ -1,32 +1,715 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
 #include "TicketManager.h"
 #include "TrainScheduler.h"
+#include "DataStructure/FileSync.h"
+#include "DataStructure/FormatVersion.h"
+#include "DataStructure/HashTable.h"
 #include "DataStructure/List.h"
 
 namespace trainsys {
-    TicketManager::TicketManager(const std::string &filename) : ticketInfo(filename) {
+    bool TicketManager::DailyTickets::exists(const std::string &name) {
+        return InventoryTree::exists(name + "_inventory");
+    }
+
+    // exists检查的seatInventory最后改名，中途崩溃后exists(from)仍为真，再次调用会把剩下的树改完
+    void TicketManager::DailyTickets::rename(const std::string &from, const std::string &to) {
+        TicketTree::rename(from, to);
+        SeatTree::rename(from + "_seats", to + "_seats");
+        InventoryTree::rename(from + "_inventory", to + "_inventory");
+    }
+
+    void TicketManager::DailyTickets::sync(const std::string &name) {
+        TicketTree::sync(name);
+        SeatTree::sync(name + "_seats");
+        InventoryTree::sync(name + "_inventory");
+    }
+
+    void TicketManager::DailyTickets::destroy(const std::string &name) {
+        TicketTree::destroy(name);
+        InventoryTree::destroy(name + "_inventory");
+        SeatTree::destroy(name + "_seats");
+    }
+
+    // 本地时间的年份和日期，2月29日按3月1日处理
+    static std::tm localToday() {
+        std::time_t now = std::time(nullptr);
+        std::tm today = *std::localtime(&now);
+        if (today.tm_mon == 1 && today.tm_mday == 29) today.tm_mon = 2, today.tm_mday = 1;
+        return today;
+    }
+
+    TicketManager::TicketManager(const std::string &filename) : TicketManager(filename, localToday()) {
+    }
+
+    TicketManager::TicketManager(const std::string &filename, const std::tm &today)
+        : TicketManager(filename, today.tm_year + 1900, Date(today.tm_mon + 1, today.tm_mday)) {
+    }
+
+    TicketManager::TicketManager(const std::string &filename, int saleYear, const Date &saleStart)
+        : filename(filename), saleYear(saleYear), saleStart(saleStart), legacyLayout(false), hotCount(0),
+          changeLog(nullptr), flushRequested(false), stopping(false) {
+        for (int day = 0; day < DAYS_PER_YEAR; ++day) {
+            partitions[day] = nullptr;
+            absent[day] = false;
+            generations[day].store(0, std::memory_order_relaxed);
+        }
+        upgradeLayout();
+        recoverRelease();
+        flusher = std::thread([this]() { flushLoop(); });
     }
 
     TicketManager::~TicketManager() {
+        {
+            std::lock_guard<std::mutex> guard(changeLogLock);
+            stopping = true;
+        }
+        changeLogSignal.notify_one();
+        flusher.join();
+        flushChangeLog();
+        for (int day = 0; day < DAYS_PER_YEAR; ++day) delete partitions[day];
+        for (int i = 0; i < TICKET_INVENTORY_SHARD_COUNT; ++i) {
+            seqList<VersionedInventory *> &owned = inventoryShards[i].owned;
+            for (int j = 0; j < owned.length(); ++j) releaseRecord(owned.visit(j));
+        }
+    }
+
+    int TicketManager::reserve(const TrainID &trainID, const Date &date, int fromIdx, int toIdx, int count) {
+        if (count <= 0) return -1;
+        TrainDayKey key(trainID, date);
+        return adjustSeat(findRecord(key).get(), fromIdx, toIdx, -count);
+    }
+
+    int TicketManager::release(const TrainID &trainID, const Date &date, int fromIdx, int toIdx, int count) {
+        if (count <= 0) return -1;
+        TrainDayKey key(trainID, date);
+        return adjustSeat(findRecord(key).get(), fromIdx, toIdx, count);
     }
 
     int TicketManager::querySeat(const TrainID &trainID, const Date &date, const StationID &stationID) {
-        /* Question */
-        seqList<TicketInfo> relatedInfo = ticketInfo.find(trainID);
-        for (int i = 0; i < relatedInfo.length(); ++i) {
-            if (relatedInfo.visit(i).date == date && relatedInfo.visit(i).departureStation == stationID) {
-                return relatedInfo.visit(i).seatNum;
+        RecordRef ref = findRecord(TrainDayKey(trainID, date));
+        VersionedInventory *record = ref.get();
+        if (record == nullptr) return -1; //没有找到符合条件的车票
+        int i = record->findStation(stationID);
+        return readSeat(record, i, i + 1);
+    }
+
+    // 从stationID出发的一段余票数加上delta，返回修改后的余票数；车票不存在或余票不足时不做修改，返回-1
+    int TicketManager::updateSeat(const TrainID &trainID, const Date &date, const StationID &stationID, int delta) {
+        TrainDayKey key(trainID, date);
+        RecordRef ref = findRecord(key);
+        VersionedInventory *record = ref.get();
+        if (record == nullptr) return -1;
+        int i = record->findStation(stationID);
+        return adjustSeat(record, i, i + 1, delta);
+    }
+
+    // 从departureStation到arrivalStation途经各段余票的最小值，车票不存在或两站次序不对时返回-1
+    int TicketManager::querySeat(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                                 const StationID &arrivalStation) {
+        RecordRef ref = findRecord(TrainDayKey(trainID, date));
+        VersionedInventory *record = ref.get();
+        int l, r;
+        if (!segmentRange(record, departureStation, arrivalStation, l, r)) return -1;
+        return readSeat(record, l, r);
+    }
+
+    // 从departureStation到arrivalStation途经各段的余票都加上delta（预订为负，退票为正），返回修改后的余票数
+    // 车票不存在、两站次序不对或余票不足时不做修改，返回-1
+    int TicketManager::updateSeat(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                                  const StationID &arrivalStation, int delta) {
+        TrainDayKey key(trainID, date);
+        RecordRef ref = findRecord(key);
+        VersionedInventory *record = ref.get();
+        int l, r;
+        if (!segmentRange(record, departureStation, arrivalStation, l, r)) return -1;
+        return adjustSeat(record, l, r, delta);
+    }
+
+    // 在同一次提交中占用座位并扣减余票：没有空座或余票不足（只按余票售出过车票）时不做修改
+    int TicketManager::assignSeat(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                                  const StationID &arrivalStation) {
+        TrainDayKey key(trainID, date);
+        RecordRef ref = findRecord(key);
+        VersionedInventory *record = ref.get();
+        int l, r;
+        if (!segmentRange(record, departureStation, arrivalStation, l, r)) return -1;
+        uint64_t mask = SeatBlock::segmentMask(l, r);
+        int seat = -1;
+        bool assigned = commitSeat(record, [&]() {
+            seat = record->findFreeSeat(mask);
+            return seat >= 0 && record->query(l, r) > 0;
+        }, [&]() {
+            std::atomic<uint64_t> &word = record->seatWords[seat];
+            word.store(word.load(std::memory_order_relaxed) | mask, std::memory_order_relaxed);
+            record->add(l, r, -1);
+            record->seatsChanged.store(true, std::memory_order_relaxed);
+        });
+        return assigned ? seat : -1;
+    }
+
+    bool TicketManager::releaseSeat(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                                    const StationID &arrivalStation, int seat) {
+        TrainDayKey key(trainID, date);
+        RecordRef ref = findRecord(key);
+        VersionedInventory *record = ref.get();
+        int l, r;
+        if (!segmentRange(record, departureStation, arrivalStation, l, r)) return false;
+        if (seat < 0 || seat >= record->seatBlockCount * SeatBlock::SEATS_PER_BLOCK) return false;
+        uint64_t mask = SeatBlock::segmentMask(l, r);
+        std::atomic<uint64_t> &word = record->seatWords[seat];
+        return commitSeat(record, [&]() {
+            return (word.load(std::memory_order_relaxed) & mask) == mask;
+        }, [&]() {
+            word.store(word.load(std::memory_order_relaxed) & ~mask, std::memory_order_relaxed);
+            record->add(l, r, 1);
+            record->seatsChanged.store(true, std::memory_order_relaxed);
+        });
+    }
+
+    // 座位图上的空座数和余票数取自同一个快照，只按余票售出的车票也会减少能分配的座位
+    int TicketManager::countFreeSeats(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                                      const StationID &arrivalStation) {
+        RecordRef ref = findRecord(TrainDayKey(trainID, date));
+        VersionedInventory *record = ref.get();
+        int l, r;
+        if (!segmentRange(record, departureStation, arrivalStation, l, r)) return -1;
+        uint64_t mask = SeatBlock::segmentMask(l, r);
+        int count = 0;
+        readSnapshot(record, [&]() {
+            int free = record->countFreeSeats(mask), seatNum = record->query(l, r);
+            count = free < seatNum ? free : seatNum;
+        });
+        return count;
+    }
+
+    TicketManager::InventoryShard &TicketManager::shardOf(const TrainDayKey &key) {
+        unsigned long long h = 14695981039346656037ULL;
+        for (const char *p = key.trainID.index; *p; ++p) h = (h ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+        return inventoryShards[Hash<unsigned long long>()(h ^ key.date.day) % TICKET_INVENTORY_SHARD_COUNT];
+    }
+
+    // 售票窗口内的日期所在的年份
+    int TicketManager::yearOf(const Date &date) const {
+        return date < saleStart ? saleYear + 1 : saleYear;
+    }
+
+    std::string TicketManager::partitionName(const Date &date) const {
+        return partitionName(yearOf(date), date);
+    }
+
+    std::string TicketManager::partitionName(int year, const Date &date) const {
+        if (legacyLayout) return filename + "_" + std::string(date);
+        return filename + "_" + std::to_string(year) + "-" + std::string(date);
+    }
+
+    std::string TicketManager::stagingName(const Date &date) const {
+        return partitionName(date) + ".staging";
+    }
+
+    std::string TicketManager::stagingName(int year, const Date &date) const {
+        return partitionName(year, date) + ".staging";
+    }
+
+    std::string TicketManager::manifestName() const {
+        return filename + "_release.commit";
+    }
+
+    // 某一天的分区，不存在时按create决定是否新建；调用者须持有storageLock
+    TicketManager::DailyTickets *TicketManager::partition(const Date &date, bool create) {
+        DailyTickets *&daily = partitions[date.day];
+        if (daily != nullptr) return daily;
+        if (!create && (absent[date.day] || !DailyTickets::exists(partitionName(date)))) {
+            absent[date.day] = true;
+            return nullptr;
+        }
+        absent[date.day] = false;
+        daily = new DailyTickets(partitionName(date));
+        return daily;
+    }
+
+    // 删除一天的分区；内存中这一天的余票记录随代数增加而作废，下次访问时重新读入。调用者须持有storageLock，
+    // 释放storageLock后再调用purgeDate把作废的记录移出分片
+    void TicketManager::dropPartition(const Date &date) {
+        delete partitions[date.day];
+        partitions[date.day] = nullptr;
+        DailyTickets::destroy(partitionName(date));
+        absent[date.day] = true;
+        generations[date.day].fetch_add(1, std::memory_order_release);
+    }
+
+    // 内存中的余票记录，第一次访问或所在分区被删除过时从seatInventory和seatMap读入；车票不存在时引用为空
+    // 加锁次序总是分片锁在前、storageLock在后
+    TicketManager::RecordRef TicketManager::findRecord(const TrainDayKey &key) {
+        InventoryShard &shard = shardOf(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        DataType<TrainDayKey, VersionedInventory *> *entry = shard.records.find(key);
+        if (entry != nullptr) {
+            VersionedInventory *record = entry->value;
+            if (record->generation == generations[key.date.day].load(std::memory_order_acquire)) {
+                // 访问次数达到阈值且热层未满时进入热层
+                if (++record->hits == TICKET_HOT_THRESHOLD) {
+                    if (hotCount.fetch_add(1, std::memory_order_relaxed) < TICKET_HOT_CAPACITY) {
+                        record->hot.store(true, std::memory_order_release);
+                    } else {
+                        hotCount.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                }
+                record->refs.fetch_add(1, std::memory_order_relaxed);
+                return RecordRef(record);
             }
+            // 作废的记录留在owned中，由purgeDate移出并归还热层名额
+            shard.records.remove(key);
+        }
+        VersionedInventory *record = nullptr;
+        {
+            std::lock_guard<std::mutex> storageGuard(storageLock);
+            DailyTickets *daily = partition(key.date, false);
+            if (daily != nullptr) {
+                unsigned generation = generations[key.date.day].load(std::memory_order_relaxed);
+                daily->seatInventory.forEach(key, [&](const SeatInventory &inventory) {
+                    std::vector<SeatBlock> blocks;
+                    forEachSeatBlock(daily, key.trainID, key.date, [&blocks](const SeatBlockKey &, const SeatBlock &block) {
+                        blocks.push_back(block);
+                    });
+                    record = new VersionedInventory(key, inventory, blocks.data(), blocks.size(), generation);
+                }, 0, 1);
+            }
+        }
+        if (record != nullptr) {
+            shard.records.insert(DataType<TrainDayKey, VersionedInventory *>{key, record});
+            shard.owned.pushBack(record);
+            record->refs.fetch_add(1, std::memory_order_relaxed);
         }
-    return -1; //没有找到符合条件的车票
+        return RecordRef(record);
     }
 
-    int TicketManager::updateSeat(const TrainID &trainID, const Date &date, const StationID &stationID, int delta) {
-        /* Question */
-        return 0；
+    void TicketManager::releaseRecord(VersionedInventory *record) {
+        if (record->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete record;
+    }
+
+    // 把分片中满足match的记录移出查找表和owned，归还热层名额并释放owned持有的引用；调用者须持有分片锁
+    template<class Predicate>
+    void TicketManager::detachRecords(InventoryShard &shard, Predicate match) {
+        seqList<VersionedInventory *> kept;
+        for (int i = 0; i < shard.owned.length(); ++i) {
+            VersionedInventory *record = shard.owned.visit(i);
+            if (!match(record)) {
+                kept.pushBack(record);
+                continue;
+            }
+            DataType<TrainDayKey, VersionedInventory *> *entry = shard.records.find(record->key);
+            if (entry != nullptr && entry->value == record) shard.records.remove(record->key);
+            if (record->hot.load(std::memory_order_relaxed)) hotCount.fetch_sub(1, std::memory_order_relaxed);
+            releaseRecord(record);
+        }
+        if (kept.length() == shard.owned.length()) return;
+        shard.owned.clear();
+        for (int i = 0; i < kept.length(); ++i) shard.owned.pushBack(kept.visit(i));
+    }
+
+    // 移出这一天已作废的记录；分区删除后读入的新记录代数不同，不受影响
+    void TicketManager::purgeDate(const Date &date) {
+        unsigned generation = generations[date.day].load(std::memory_order_acquire);
+        for (InventoryShard &shard : inventoryShards) {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            detachRecords(shard, [&date, generation](const VersionedInventory *record) {
+                return record->key.date == date && record->generation != generation;
+            });
+        }
+    }
+
+    // 反复调用read直到它读到一致的快照，read可能读到写了一半的数据，只能把结果存下来，不能据此做别的事
+    template<class Read>
+    void TicketManager::readSnapshot(const VersionedInventory *record, Read read) {
+        while (true) {
+            unsigned long long version = record->version.load(std::memory_order_acquire);
+            if ((version & 1) == 0) {
+                read();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (record->version.load(std::memory_order_relaxed) == version) return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // 在读到的版本上调用decide检查能否修改，CAS成功才调用apply写入，两个线程抢最后一张票时只有先CAS成功的一个能成功；
+    // decide返回false的结论也要在一致的快照上得出。提交只写内存，写回交给变更日志
+    template<class Decide, class Apply>
+    bool TicketManager::commitSeat(VersionedInventory *record, Decide decide, Apply apply) {
+        while (true) {
+            unsigned long long version = record->version.load(std::memory_order_acquire);
+            if ((version & 1) == 0) {
+                if (!decide()) {
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (record->version.load(std::memory_order_relaxed) == version) return false;
+                } else if (record->version.compare_exchange_weak(version, version + 1, std::memory_order_acq_rel)) {
+                    apply();
+                    record->version.store(version + 2, std::memory_order_release);
+                    logChange(record);
+                    return true;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    int TicketManager::readSeat(VersionedInventory *record, int l, int r) {
+        if (record == nullptr || l < 0 || l >= r || r >= record->stationNum) return -1;
+        int seatNum;
+        readSnapshot(record, [&]() { seatNum = record->query(l, r); });
+        return seatNum;
+    }
+
+    int TicketManager::adjustSeat(VersionedInventory *record, int l, int r, int delta) {
+        if (record == nullptr || l < 0 || l >= r || r >= record->stationNum) return -1;
+        int seatNum;
+        bool adjusted = commitSeat(record, [&]() {
+            seatNum = record->query(l, r) + delta;
+            return seatNum >= 0;
+        }, [&]() {
+            record->add(l, r, delta);
+        });
+        return adjusted ? seatNum : -1;
+    }
+
+    // 记录第一次变脏时压入变更日志，日志持有一个引用；普通记录的修改还要唤醒后台线程尽快写回。
+    // 后台线程在检查flushRequested之后、开始等待之前错过的唤醒，最多推迟一个写回间隔
+    void TicketManager::logChange(VersionedInventory *record) {
+        if (!record->dirty.exchange(true, std::memory_order_acq_rel)) {
+            record->refs.fetch_add(1, std::memory_order_relaxed);
+            VersionedInventory *head = changeLog.load(std::memory_order_relaxed);
+            do {
+                record->nextDirty = head;
+            } while (!changeLog.compare_exchange_weak(head, record, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+        }
+        if (!record->hot.load(std::memory_order_acquire) && !flushRequested.exchange(true, std::memory_order_acq_rel)) {
+            changeLogSignal.notify_one();
+        }
+    }
+
+    // 把记录当前的快照写回所在分区，座位图只在有修改时写回；分区已删除或车次已停售时不写。
+    // 只有后台线程和析构时调用，后写回的快照一定不比先写回的旧
+    void TicketManager::persist(VersionedInventory *record) {
+        std::lock_guard<std::mutex> guard(storageLock);
+        DailyTickets *daily = partition(record->key.date, false);
+        if (daily == nullptr || record->retired ||
+            record->generation != generations[record->key.date.day].load(std::memory_order_relaxed)) {
+            return;
+        }
+        // 先清除标记再取快照，取快照之后的修改会重新置位
+        bool seatsChanged = record->seatsChanged.exchange(false, std::memory_order_acq_rel);
+        SeatInventory inventory;
+        inventory.stationNum = record->stationNum;
+        for (int i = 0; i < record->stationNum; ++i) inventory.stations[i] = record->stations[i];
+        std::vector<SeatBlock> blocks(seatsChanged ? record->seatBlockCount : 0);
+        readSnapshot(record, [&]() {
+            inventory.seats.copyFrom(record->seats);
+            for (int i = 0; i < static_cast<int>(blocks.size()) * SeatBlock::SEATS_PER_BLOCK; ++i) {
+                blocks[i / SeatBlock::SEATS_PER_BLOCK].seats[i % SeatBlock::SEATS_PER_BLOCK] =
+                        record->seatWords[i].load(std::memory_order_relaxed);
+            }
+        });
+        daily->seatInventory.updateFirst(record->key, [&inventory](SeatInventory &stored) {
+            stored = inventory;
+        });
+        for (int block = 0; block < static_cast<int>(blocks.size()); ++block) {
+            daily->seatMap.updateFirst(SeatBlockKey(record->key.trainID, record->key.date, block),
+                                       [&](SeatBlock &stored) {
+                                           stored = blocks[block];
+                                       });
+        }
+    }
+
+    // 取走整个变更日志，逐条记录清除脏标记后写回，写回时不妨碍订票；
+    // 清除之后提交的修改会让记录重新记入日志，因此先读出nextDirty再清除。只有后台线程和析构时调用
+    void TicketManager::flushChangeLog() {
+        VersionedInventory *record = changeLog.exchange(nullptr, std::memory_order_acquire);
+        while (record != nullptr) {
+            VersionedInventory *next = record->nextDirty;
+            record->dirty.store(false, std::memory_order_release);
+            persist(record);
+            releaseRecord(record);
+            record = next;
+        }
+    }
+
+    void TicketManager::flushLoop() {
+        std::unique_lock<std::mutex> lock(changeLogLock);
+        while (!stopping) {
+            changeLogSignal.wait_for(lock, std::chrono::milliseconds(TICKET_FLUSH_INTERVAL), [this]() {
+                return stopping || flushRequested.load(std::memory_order_acquire);
+            });
+            if (stopping) break;
+            flushRequested.store(false, std::memory_order_release);
+            if (changeLog.load(std::memory_order_acquire) == nullptr) continue;
+            lock.unlock();
+            flushChangeLog();
+            lock.lock();
+        }
+    }
+
+    // 两站在经停站中的下标，车票不存在或两站次序不对时返回false
+    bool TicketManager::segmentRange(const VersionedInventory *record, const StationID &departureStation,
+                                     const StationID &arrivalStation, int &l, int &r) {
+        l = r = -1;
+        if (record == nullptr) return false;
+        l = record->findStation(departureStation), r = record->findStation(arrivalStation);
+        return l >= 0 && l < r;
     }
 
     void TicketManager::releaseTicket(const TrainScheduler &scheduler, const Date &date) {
-        /* Question */
+        std::lock_guard<std::mutex> guard(storageLock);
+        releaseInto(partition(date, true), scheduler, date);
+    }
+
+    void TicketManager::releaseDate(const TrainScheduler *schedulers, int n, const Date &date) {
+        releaseRange(schedulers, n, date, date);
+    }
+
+    // 一个车次放票时生成的记录，与日期无关的部分只生成一次，写入各天的分区时再填上日期
+    struct TicketManager::ReleasedTrain {
+        TrainID trainID;
+        int seatNum;
+        std::vector<TicketInfo> tickets; // 按出发站排序，即在分区中的顺序
+        SeatInventory inventory;
+
+        // Scheduler为TrainScheduler或TrainSchedulerView，各字段批量读取一次，视图不必按下标逐次解码
+        template<class Scheduler>
+        explicit ReleasedTrain(const Scheduler &scheduler)
+            : trainID(scheduler.getTrainID()), seatNum(scheduler.getSeatNum()) {
+            int passingStationNum = scheduler.getPassingStationNum();
+            StationID stations[MAX_PASSING_STATION_NUMBER];
+            int duration[MAX_PASSING_STATION_NUMBER], price[MAX_PASSING_STATION_NUMBER];
+            scheduler.getStations(stations);
+            scheduler.getDuration(duration);
+            scheduler.getPrice(price);
+            for (int i = 0; i + 1 < passingStationNum; ++i) {
+                TicketInfo newTicket;
+                newTicket.trainID = trainID;
+                newTicket.departureStation = stations[i];
+                newTicket.arrivalStation = stations[i + 1];
+                newTicket.seatNum = seatNum;
+                newTicket.price = price[i];
+                newTicket.duration = duration[i];
+                tickets.push_back(newTicket);
+            }
+            std::sort(tickets.begin(), tickets.end(), [](const TicketInfo &lhs, const TicketInfo &rhs) {
+                return lhs.departureStation < rhs.departureStation;
+            });
+            inventory = SeatInventory(stations, passingStationNum, seatNum);
+        }
+    };
+
+    // 用不超过硬件线程数的工作线程执行task(0), ..., task(n - 1)，每个线程从计数器领取下一个任务
+    template<class Task>
+    static void parallelFor(int n, Task task) {
+        int workerCount = std::thread::hardware_concurrency();
+        if (workerCount > n) workerCount = n;
+        if (workerCount <= 1) {
+            for (int i = 0; i < n; ++i) task(i);
+            return;
+        }
+        std::atomic<int> next(0);
+        std::vector<std::thread> workers;
+        for (int w = 0; w < workerCount; ++w) {
+            workers.emplace_back([&next, &task, n]() {
+                for (int i = next++; i < n; i = next++) task(i);
+            });
+        }
+        for (std::thread &worker : workers) worker.join();
+    }
+
+    void TicketManager::releaseRange(const TrainScheduler *schedulers, int n, const Date &dateFrom,
+                                     const Date &dateTo) {
+        releaseSchedulers(schedulers, n, dateFrom, dateTo);
+    }
+
+    void TicketManager::releaseRange(const TrainSchedulerView *schedulers, int n, const Date &dateFrom,
+                                     const Date &dateTo) {
+        releaseSchedulers(schedulers, n, dateFrom, dateTo);
+    }
+
+    template<class Scheduler>
+    void TicketManager::releaseSchedulers(const Scheduler *schedulers, int n, const Date &dateFrom,
+                                          const Date &dateTo) {
+        if (dateFrom.day >= DAYS_PER_YEAR || dateTo.day >= DAYS_PER_YEAR) throw std::out_of_range("Date out of range");
+        if (dateTo < dateFrom) throw std::invalid_argument("Invalid date range");
+        if (n <= 0) return;
+        std::vector<const Scheduler *> order;
+        for (int i = 0; i < n; ++i) order.push_back(schedulers + i);
+        std::sort(order.begin(), order.end(), [](const Scheduler *lhs, const Scheduler *rhs) {
+            return lhs->getTrainID() < rhs->getTrainID();
+        });
+        order.erase(std::unique(order.begin(), order.end(), [](const Scheduler *lhs, const Scheduler *rhs) {
+            return lhs->getTrainID() == rhs->getTrainID();
+        }), order.end());
+        std::vector<ReleasedTrain *> trains(order.size());
+        parallelFor(order.size(), [&](int i) { trains[i] = new ReleasedTrain(*order[i]); });
+
+        // 持有storageLock直到提交完成；各天的分区互不相关，可以并行生成临时分区。
+        // 临时分区只含新放票的车次，提交时原有的记录不动，内存中的余票记录不作废
+        std::lock_guard<std::mutex> guard(storageLock);
+        int dayCount = dateTo - dateFrom + 1;
+        std::vector<char> staged(dayCount, 0);
+        parallelFor(dayCount, [&](int i) {
+            staged[i] = stagePartition(dateFrom + i, trains.data(), trains.size());
+        });
+        // 清单先写出日期数再逐行写出各个日期的年份和天数，读到的日期不足时说明清单没有写完，不能提交
+        std::ofstream manifest(manifestName(), std::ios::out | std::ios::trunc);
+        manifest << std::count(staged.begin(), staged.end(), 1) << '\n';
+        for (int i = 0; i < dayCount; ++i) {
+            if (staged[i]) manifest << yearOf(dateFrom + i) << ' ' << (dateFrom + i).day << '\n';
+        }
+        manifest.close();
+        // 临时分区在staging时已刷盘，清单和目录项都落盘后才算提交
+        syncFile(manifestName().c_str());
+        syncDirectoryOf(filename);
+        recoverRelease();
+        for (ReleasedTrain *train : trains) delete train;
+    }
+
+    // 把这一天尚未放票的车次批量建到临时分区，已有的记录不读出也不复制；没有要放票的车次时返回false
+    // 只访问这一天的分区，不同日期可以在不同线程上同时调用
+    bool TicketManager::stagePartition(const Date &date, ReleasedTrain *const *trains, int n) {
+        // trains按车次升序，同一天的键也按车次升序，一趟批量查找即可找出已放过票的车次
+        std::vector<char> released(n, 0);
+        DailyTickets *daily = partition(date, false);
+        if (daily != nullptr) {
+            std::vector<TrainDayKey> keys;
+            for (int i = 0; i < n; ++i) keys.push_back(TrainDayKey(trains[i]->trainID, date));
+            daily->seatInventory.forEachSorted(keys.data(), n, [&released](int i, const SeatInventory &) {
+                released[i] = 1;
+            });
+        }
+        std::vector<Pair<TicketKey, TicketInfo> > tickets;
+        std::vector<Pair<TrainDayKey, SeatInventory> > inventories;
+        std::vector<Pair<SeatBlockKey, SeatBlock> > blocks;
+        for (int i = 0; i < n; ++i) {
+            if (released[i]) continue;
+            const ReleasedTrain &train = *trains[i];
+            for (const TicketInfo &ticket : train.tickets) {
+                tickets.push_back(Pair<TicketKey, TicketInfo>(TicketKey(train.trainID, date, ticket.departureStation),
+                                                              ticket));
+                tickets.back().second.date = date;
+            }
+            inventories.push_back(Pair<TrainDayKey, SeatInventory>(TrainDayKey(train.trainID, date), train.inventory));
+            for (int block = 0; block * SeatBlock::SEATS_PER_BLOCK < train.seatNum; ++block) {
+                blocks.push_back(Pair<SeatBlockKey, SeatBlock>(
+                    SeatBlockKey(train.trainID, date, block),
+                    SeatBlock(train.seatNum - block * SeatBlock::SEATS_PER_BLOCK)));
+            }
+        }
+        if (inventories.empty()) return false;
+        DailyTickets::destroy(stagingName(date));
+        DailyTickets *staging = new DailyTickets(stagingName(date));
+        staging->ticketInfo.bulkLoad(tickets.data(), tickets.size());
+        staging->seatInventory.bulkLoad(inventories.data(), inventories.size());
+        staging->seatMap.bulkLoad(blocks.data(), blocks.size());
+        delete staging;
+        DailyTickets::sync(stagingName(date));
+        return true;
+    }
+
+    // 把临时分区中的记录插入已有的分区，已经存在的记录跳过，中途崩溃后重新执行结果不变。
+    // 每个车次的余票记录在车票和座位图之后插入，余票记录存在说明这个车次已经插完
+    void TicketManager::applyStaged(DailyTickets *daily, const std::string &staging) {
+        DailyTickets staged(staging);
+        staged.ticketInfo.forEachEntry([daily](const TicketKey &key, const TicketInfo &info) {
+            if (!daily->ticketInfo.contains(key)) daily->ticketInfo.insert(key, info);
+        });
+        staged.seatInventory.forEachEntry([daily, &staged](const TrainDayKey &key, const SeatInventory &inventory) {
+            if (daily->seatInventory.contains(key)) return;
+            forEachSeatBlock(&staged, key.trainID, key.date, [daily](const SeatBlockKey &blockKey, const SeatBlock &block) {
+                daily->seatMap.insert(blockKey, block);
+            });
+            daily->seatInventory.insert(key, inventory);
+        });
+    }
+
+    // 按提交清单提交各天的临时分区，清单不完整时视为没有提交；最后删除所有临时分区
+    // 构造时和releaseRange写完清单后调用，重复执行结果不变。这一天还没有分区时把临时分区改名过去：
+    // 文件逐个改名，中途崩溃后已改名的树留在分区名下，exists检查的余票树最后改名，重新执行只改名剩下的树；
+    // 已有分区时用applyStaged把新车次插入原分区并刷盘。改名和插入都落盘后才删除清单
+    // 清单记下了年份，售票窗口在崩溃后移动过时仍替换到原来的年份；版本1的清单只有天数
+    void TicketManager::recoverRelease() {
+        std::ifstream manifest(manifestName());
+        if (manifest) {
+            int count = -1, year = saleYear, day;
+            seqList<Pair<int, int> > days;
+            manifest >> count;
+            while (days.length() < count && (legacyLayout || manifest >> year) && manifest >> day && day >= 0 &&
+                   day < DAYS_PER_YEAR) {
+                days.pushBack(Pair<int, int>(year, day));
+            }
+            manifest.close();
+            for (int i = 0; days.length() == count && i < count; ++i) {
+                year = days.visit(i).first;
+                Date date = Date::ofDay(days.visit(i).second);
+                if (!DailyTickets::exists(stagingName(year, date))) continue; // 上次已经改名过
+                bool current = year == yearOf(date);
+                if (DailyTickets::exists(partitionName(year, date))) {
+                    DailyTickets *daily = current ? partition(date, false) : new DailyTickets(partitionName(year, date));
+                    applyStaged(daily, stagingName(year, date));
+                    delete daily;
+                    if (current) partitions[date.day] = nullptr;
+                    DailyTickets::sync(partitionName(year, date));
+                    continue;
+                }
+                if (current) {
+                    delete partitions[date.day];
+                    partitions[date.day] = nullptr;
+                    absent[date.day] = false;
+                }
+                DailyTickets::rename(stagingName(year, date), partitionName(year, date));
+            }
+            syncDirectoryOf(filename);
+            std::remove(manifestName().c_str());
+        }
+        // 写到一半的临时分区可能缺少seatInventory，不按exists判断；临时分区也可能属于售票窗口之外的年份，
+        // 因此按文件名找出所有临时分区的文件直接删除
+        std::filesystem::path base(filename);
+        std::filesystem::path directory = base.has_parent_path() ? base.parent_path() : std::filesystem::path(".");
+        std::string prefix = base.filename().string() + "_";
+        std::vector<std::filesystem::path> staging;
+        for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind(prefix, 0) == 0 && name.find(".staging_", prefix.size()) != std::string::npos) {
+                staging.push_back(entry.path());
+            }
+        }
+        for (const std::filesystem::path &path : staging) std::filesystem::remove(path);
+    }
+
+    // 版本1的分区文件名不带年份：先按旧文件名完成上次没有提交完的放票，再把各分区改名到售票窗口内的年份，
+    // 改名落盘后写入新版本号。改名中途崩溃时版本号仍是旧的，重新打开时只改名剩下的分区
+    void TicketManager::upgradeLayout() {
+        int version = readFormatVersion(filename);
+        if (version == FORMAT_VERSION) return;
+        if (version != 0) throw std::runtime_error("Unsupported ticket file version");
+        legacyLayout = true;
+        recoverRelease();
+        legacyLayout = false;
+        for (int day = 0; day < DAYS_PER_YEAR; ++day) {
+            Date date = Date::ofDay(day);
+            std::string legacyName = filename + "_" + std::string(date);
+            if (DailyTickets::exists(legacyName)) DailyTickets::rename(legacyName, partitionName(date));
+        }
+        syncDirectoryOf(filename);
+        writeFormatVersion(filename, FORMAT_VERSION);
+    }
+
+    void TicketManager::releaseInto(DailyTickets *daily, const TrainScheduler &scheduler, const Date &date) {
+        if (daily->seatInventory.contains(TrainDayKey(scheduler.getTrainID(), date))) {
+            return; // 同一天已经放过票
+        }
         int passingStationNum = scheduler.getPassingStationNum();
         for (int i = 0; i + 1 < passingStationNum; ++i) {
             TicketInfo newTicket;
@@ -37,17 +720,62 @@ namespace trainsys {
             newTicket.price = scheduler.getPrice(i);
             newTicket.duration = scheduler.getDuration(i);
             newTicket.date = date;
-            ticketInfo.insert(newTicket.trainID, newTicket);
+            daily->ticketInfo.insert(TicketKey(newTicket.trainID, date, newTicket.departureStation), newTicket);
+        }
+        StationID stations[MAX_PASSING_STATION_NUMBER];
+        for (int i = 0; i < passingStationNum; ++i) stations[i] = scheduler.getStation(i);
+        daily->seatInventory.insert(TrainDayKey(scheduler.getTrainID(), date),
+                                    SeatInventory(stations, passingStationNum, scheduler.getSeatNum()));
+        for (int block = 0; block * SeatBlock::SEATS_PER_BLOCK < scheduler.getSeatNum(); ++block) {
+            daily->seatMap.insert(SeatBlockKey(scheduler.getTrainID(), date, block),
+                                  SeatBlock(scheduler.getSeatNum() - block * SeatBlock::SEATS_PER_BLOCK));
         }
     }
 
     void TicketManager::expireTicket(const TrainID &trainID, const Date &date) {
-        /* Question */
-        seqList<TicketInfo> relatedInfo = ticketInfo.find(trainID);
-        for (int i = 0; i < relatedInfo.length(); ++i) {
-            if (relatedInfo.visit(i).date == date) {
-                ticketInfo.remove(trainID, relatedInfo.visit(i));
+        // 删除期间一直持有分片锁，其他线程不会把正在删除的记录重新读入内存
+        TrainDayKey key(trainID, date);
+        InventoryShard &shard = shardOf(key);
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            DataType<TrainDayKey, VersionedInventory *> *entry = shard.records.find(key);
+            VersionedInventory *record = entry != nullptr ? entry->value : nullptr;
+            std::lock_guard<std::mutex> storageGuard(storageLock);
+            if (record != nullptr) {
+                record->retired = true;
+                detachRecords(shard, [record](const VersionedInventory *other) { return other == record; });
             }
+            DailyTickets *daily = partition(date, false);
+            if (daily == nullptr || !daily->seatInventory.contains(key)) return;
+            if (daily->seatInventory.size() > 1) {
+                // 先收集当天的车票再逐个删除，遍历过程中不能修改B+树
+                seqList<TicketInfo> relatedInfo;
+                daily->ticketInfo.forEachInRange(TicketKey(trainID, date, std::numeric_limits<StationID>::min()),
+                                                 TicketKey(trainID, date, std::numeric_limits<StationID>::max()),
+                                                 [&relatedInfo](const TicketKey &, const TicketInfo &info) {
+                                                     relatedInfo.pushBack(info);
+                                                 });
+                for (int i = 0; i < relatedInfo.length(); ++i) {
+                    const TicketInfo &info = relatedInfo.visit(i);
+                    daily->ticketInfo.remove(TicketKey(trainID, date, info.departureStation), info);
+                }
+                daily->seatInventory.removeFirst(key);
+                int blockCount = forEachSeatBlock(daily, trainID, date, [](const SeatBlockKey &, const SeatBlock &) {});
+                for (int block = 0; block < blockCount; ++block) {
+                    daily->seatMap.removeFirst(SeatBlockKey(trainID, date, block));
+                }
+                return;
+            }
+            dropPartition(date);
+        }
+        purgeDate(date);
+    }
+
+    void TicketManager::expireDate(const Date &date) {
+        {
+            std::lock_guard<std::mutex> guard(storageLock);
+            dropPartition(date);
         }
+        purgeDate(date);
     }
 }
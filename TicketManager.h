@@ -1,28 +1,326 @@
 #ifndef TICKET_MANAGER_H_
 #define TICKET_MANAGER_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <limits>
+#include <mutex>
+#include <thread>
 #include "Utils.h"
 #include "TicketInfo.h"
+#include "SeatInventory.h"
+#include "SeatBitmap.h"
 #include "TrainScheduler.h"
 #include "DataStructure/BPlusTree.h"
+#include "DataStructure/IndexOrder.h"
+#include "DataStructure/RedBlackTree.h"
 
 namespace trainsys {
+    // 可以被多个线程同时调用：余票和座位的检查和修改对每条记录的版本号做乐观CAS，不经过全局锁；
+    // 几棵B+树不是线程安全的，对文件的读写由storageLock串行化
+    // 车票按发车日期分区，每天一组B+树（文件名为filename_年-月-日），停售整天只需删除这一组文件
+    // Date不带年份：售票窗口为从saleStart起的DAYS_PER_YEAR天，saleStart及之后的日期属于saleYear，之前的日期属于下一年，
+    // 去年同一天留下的分区文件名不同，不会被当作今年的车票
+    // 分区的格式版本记在filename_version中；没有版本文件的已有分区是版本1（文件名为filename_月-日），构造时改名到售票窗口内的年份
+    // 修改只记入无锁的变更日志，由后台线程写回，订票和查询不等待storageLock和磁盘：
+    // 普通记录的修改提交后立即唤醒后台线程，访问频繁的车次日期进入热层，修改按间隔批量写回
     class TicketManager {
     private:
-        BPlusTree<TrainID, TicketInfo> ticketInfo;
+        static const int FORMAT_VERSION = 2;
+
+        struct DailyTickets {
+            typedef BPlusTree<TicketKey, TicketInfo> TicketTree;
+            // 同一车次同一天、同一座位块都只有一条记录，按映射模式存放，值只按键比较
+            typedef BPlusTree<TrainDayKey, SeatInventory, 16, 16, true> InventoryTree;
+            typedef BPlusTree<SeatBlockKey, SeatBlock, 16, 16, true> SeatTree;
+
+            TicketTree ticketInfo;
+            // 余票以seatInventory为准，TicketInfo::seatNum为放票时的座位数；记录较大，用较小的结点
+            InventoryTree seatInventory;
+            // 具体座位的占用情况，assignSeat/releaseSeat在修改座位图的同时维护seatInventory中的余票数
+            SeatTree seatMap;
+
+            explicit DailyTickets(const std::string &name)
+                : ticketInfo(name, true), seatInventory(name + "_inventory"), seatMap(name + "_seats") {
+            }
+
+            static bool exists(const std::string &name);
+
+            static void rename(const std::string &from, const std::string &to);
+
+            static void destroy(const std::string &name);
+
+            // 把三棵树的文件刷到磁盘，分区不能处于打开状态
+            static void sync(const std::string &name);
+        };
+
+        // 内存中某车次某一天的余票和座位图。version为奇数时有线程正在写入，写完后变为下一个偶数。
+        // 读取不占有记录：读前后version相同且为偶数时读到的是一致的快照，否则重读。
+        // 修改时先读version、余票和座位图并算出结果，再用CAS把version从读到的值改为奇数，成功说明期间没有别的提交，
+        // 写入后version再加1；CAS失败则从头重试。余票和座位图在同一次提交中修改，分配座位与扣减余票对读者总是同时可见。
+        // key、stationNum、stations、stationOrder和座位数放票后不再变化，可以直接读
+        struct VersionedInventory {
+            std::atomic<unsigned long long> version;
+            std::atomic<bool> hot; // 已进入热层，修改按间隔写回
+            std::atomic<bool> dirty; // 有修改尚未写回，且已记入变更日志
+            std::atomic<bool> seatsChanged; // 座位图有修改尚未写回
+            std::atomic<int> refs; // 分片的owned表、变更日志和正在使用记录的调用各持有一个引用，减到0时删除
+            VersionedInventory *nextDirty; // 变更日志中的下一条记录，由dirty的交换保证同一时刻只在日志中出现一次
+            int hits; // 访问次数，由分片锁保护
+            unsigned generation; // 读入时所在分区的代数，分区删除后记录作废
+            bool retired; // 车次已停售，不再写回；由storageLock保护
+            TrainDayKey key;
+            int stationNum;
+            StationID stations[MAX_PASSING_STATION_NUMBER];
+            unsigned char stationOrder[MAX_PASSING_STATION_NUMBER]; // stations的有序下标表，见IndexOrder.h
+            SeatSegmentTree<std::atomic<int> > seats;
+            int seatBlockCount;
+            std::atomic<uint64_t> *seatWords; // 各座位块的座位依次排列，含义同SeatBlock::seats
+
+            VersionedInventory(const TrainDayKey &key, const SeatInventory &inventory, const SeatBlock *blocks,
+                               int blockCount, unsigned generation)
+                : version(0), hot(false), dirty(false), seatsChanged(false), refs(1), nextDirty(nullptr), hits(0),
+                  generation(generation), retired(false), key(key), stationNum(inventory.stationNum),
+                  seatBlockCount(blockCount), seatWords(new std::atomic<uint64_t>[blockCount * SeatBlock::SEATS_PER_BLOCK]) {
+                for (int i = 0; i < stationNum; ++i) stations[i] = inventory.stations[i];
+                buildIndexOrder(stations, stationNum, stationOrder);
+                seats.copyFrom(inventory.seats);
+                for (int i = 0; i < blockCount * SeatBlock::SEATS_PER_BLOCK; ++i) {
+                    seatWords[i].store(blocks[i / SeatBlock::SEATS_PER_BLOCK].seats[i % SeatBlock::SEATS_PER_BLOCK],
+                                       std::memory_order_relaxed);
+                }
+            }
+
+            VersionedInventory(const VersionedInventory &) = delete;
+
+            VersionedInventory &operator=(const VersionedInventory &) = delete;
+
+            ~VersionedInventory() {
+                delete[] seatWords;
+            }
+
+            // 站点在经停站中的下标，不经停时返回-1
+            int findStation(const StationID &station) const {
+                return findInIndexOrder(stations, stationOrder, stationNum, station);
+            }
+
+            // 以下几个函数不检查version，由调用者在快照内或提交期间调用
+            int query(int l, int r) const {
+                return seats.query(l, r);
+            }
+
+            void add(int l, int r, int delta) {
+                seats.add(l, r, delta);
+            }
+
+            // 第一个在mask各段上都空闲的座位，没有时返回-1
+            int findFreeSeat(uint64_t mask) const {
+                for (int i = 0; i < seatBlockCount * SeatBlock::SEATS_PER_BLOCK; ++i) {
+                    if ((seatWords[i].load(std::memory_order_relaxed) & mask) == 0) return i;
+                }
+                return -1;
+            }
+
+            int countFreeSeats(uint64_t mask) const {
+                int count = 0;
+                for (int i = 0; i < seatBlockCount * SeatBlock::SEATS_PER_BLOCK; ++i) {
+                    count += (seatWords[i].load(std::memory_order_relaxed) & mask) == 0;
+                }
+                return count;
+            }
+        };
+
+        // 记录按车次和日期的哈希值分片，分片锁只保护查找表，不在检查和修改余票期间持有
+        struct InventoryShard {
+            std::mutex lock;
+            RedBlackTree<TrainDayKey, VersionedInventory *> records;
+            seqList<VersionedInventory *> owned; // 分片中的所有记录，包括已从records中替换掉的作废记录
+        };
+
+        // findRecord取得的记录引用，析构时释放；记录从分片中移除后，最后一个引用释放时删除记录
+        class RecordRef {
+        private:
+            VersionedInventory *record;
+
+        public:
+            explicit RecordRef(VersionedInventory *record) : record(record) {}
+
+            RecordRef(const RecordRef &) = delete;
+
+            RecordRef &operator=(const RecordRef &) = delete;
+
+            ~RecordRef() {
+                if (record != nullptr) releaseRecord(record);
+            }
+
+            VersionedInventory *get() const { return record; }
+        };
+
+        InventoryShard inventoryShards[TICKET_INVENTORY_SHARD_COUNT];
+        std::mutex storageLock;
+
+        // 以下由storageLock保护，generations可以不加锁读
+        std::string filename;
+        int saleYear;
+        Date saleStart;
+        bool legacyLayout; // 只在构造时升级版本1的分区期间为真，分区按不带年份的文件名访问
+        DailyTickets *partitions[DAYS_PER_YEAR]; // 按需打开
+        bool absent[DAYS_PER_YEAR]; // 已确认磁盘上没有这一天的分区
+        std::atomic<unsigned> generations[DAYS_PER_YEAR]; // 分区每删除一次加一
+
+        // 变更日志：记录第一次变脏时压入以nextDirty相连的无锁栈，后台线程整个取走并写回；
+        // 有普通记录变脏时置位flushRequested并唤醒后台线程，否则每TICKET_FLUSH_INTERVAL毫秒写回一次。
+        // changeLogLock只配合条件变量使用，订票路径上不加锁
+        std::atomic<int> hotCount;
+        std::atomic<VersionedInventory *> changeLog;
+        std::atomic<bool> flushRequested;
+        std::mutex changeLogLock;
+        std::condition_variable changeLogSignal;
+        bool stopping; // 由changeLogLock保护
+        std::thread flusher;
 
     public:
+        // 售票窗口从本地时间的今天开始
         TicketManager(const std::string &filename);
 
+        TicketManager(const std::string &filename, int saleYear, const Date &saleStart);
+
         ~TicketManager();
 
+        // 原子地预订第fromIdx站到第toIdx站途经各段的count张票，返回预订后这一区间的余票数；
+        // 车票不存在、下标不合法或余票不足时不做修改，返回-1
+        int reserve(const TrainID &trainID, const Date &date, int fromIdx, int toIdx, int count);
+
+        // 原子地退回第fromIdx站到第toIdx站途经各段的count张票，返回退回后这一区间的余票数，失败返回-1
+        int release(const TrainID &trainID, const Date &date, int fromIdx, int toIdx, int count);
+
         int querySeat(const TrainID &trainID, const Date &date, const StationID &stationID);
 
         int updateSeat(const TrainID &trainID, const Date &date, const StationID &stationID, int delta);
 
+        int querySeat(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                      const StationID &arrivalStation);
+
+        int updateSeat(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                       const StationID &arrivalStation, int delta);
+
+        // 分配一个从departureStation到arrivalStation各段都空闲的座位，返回座位号；没有这样的座位时返回-1
+        int assignSeat(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                       const StationID &arrivalStation);
+
+        // 释放assignSeat分配的座位，座位在这一区间上并未售出时返回false
+        bool releaseSeat(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                         const StationID &arrivalStation, int seat);
+
+        // 从departureStation到arrivalStation各段都空闲的座位数，即按座位能卖出的票数
+        int countFreeSeats(const TrainID &trainID, const Date &date, const StationID &departureStation,
+                           const StationID &arrivalStation);
+
         void releaseTicket(const TrainScheduler &scheduler, const Date &date);
 
+        // 放出一天内多个车次的车票，已放过票的车次跳过
+        void releaseDate(const TrainScheduler *schedulers, int n, const Date &date);
+
+        // 放出多个车次在[dateFrom, dateTo]内每一天的车票，已放过票的车次和日期跳过
+        // 各车次的记录由工作线程并行生成，每天新放票的车次并行批量建到临时分区，再通过提交清单一并提交：
+        // 这一天还没有分区时临时分区直接改名过去，否则只把新记录插入原分区。中途崩溃时，重新打开时要么全部生效，要么全部不生效
+        void releaseRange(const TrainScheduler *schedulers, int n, const Date &dateFrom, const Date &dateTo);
+
+        // 同上，直接从调度信息的视图放票，不必先展开成TrainScheduler
+        void releaseRange(const TrainSchedulerView *schedulers, int n, const Date &dateFrom, const Date &dateTo);
+
+        // 停售某车次某一天的车票，这一天最后一个车次停售后删除分区
         void expireTicket(const TrainID &trainID, const Date &date);
+
+        // 停售一天的所有车票，直接删除这一天的分区
+        void expireDate(const Date &date);
+
+        // 按出发站顺序遍历某车次某一天的所有车票，visit收到的引用只在回调期间有效
+        // 回调期间持有storageLock，不能在回调中调用TicketManager的其他方法
+        template<class Visitor>
+        int queryDailyTickets(const TrainID &trainID, const Date &date, Visitor visit) {
+            std::lock_guard<std::mutex> guard(storageLock);
+            DailyTickets *daily = partition(date, false);
+            if (daily == nullptr) return 0;
+            return daily->ticketInfo.forEachInRange(TicketKey(trainID, date, std::numeric_limits<StationID>::min()),
+                                                    TicketKey(trainID, date, std::numeric_limits<StationID>::max()),
+                                                    [&visit](const TicketKey &, const TicketInfo &info) {
+                                                        return visit(info);
+                                                    });
+        }
+
+    private:
+        struct ReleasedTrain;
+
+        TicketManager(const std::string &filename, const std::tm &today);
+
+        int yearOf(const Date &date) const;
+
+        std::string partitionName(const Date &date) const;
+
+        std::string partitionName(int year, const Date &date) const;
+
+        std::string stagingName(const Date &date) const;
+
+        std::string stagingName(int year, const Date &date) const;
+
+        std::string manifestName() const;
+
+        void recoverRelease();
+
+        void upgradeLayout();
+
+        template<class Scheduler>
+        void releaseSchedulers(const Scheduler *schedulers, int n, const Date &dateFrom, const Date &dateTo);
+
+        bool stagePartition(const Date &date, ReleasedTrain *const *trains, int n);
+
+        static void applyStaged(DailyTickets *daily, const std::string &staging);
+
+        DailyTickets *partition(const Date &date, bool create);
+
+        void dropPartition(const Date &date);
+
+        void releaseInto(DailyTickets *daily, const TrainScheduler &scheduler, const Date &date);
+
+        InventoryShard &shardOf(const TrainDayKey &key);
+
+        RecordRef findRecord(const TrainDayKey &key);
+
+        static void releaseRecord(VersionedInventory *record);
+
+        template<class Predicate>
+        void detachRecords(InventoryShard &shard, Predicate match);
+
+        void purgeDate(const Date &date);
+
+        template<class Read>
+        static void readSnapshot(const VersionedInventory *record, Read read);
+
+        template<class Decide, class Apply>
+        bool commitSeat(VersionedInventory *record, Decide decide, Apply apply);
+
+        void logChange(VersionedInventory *record);
+
+        void persist(VersionedInventory *record);
+
+        void flushChangeLog();
+
+        void flushLoop();
+
+        int readSeat(VersionedInventory *record, int l, int r);
+
+        int adjustSeat(VersionedInventory *record, int l, int r, int delta);
+
+        static bool segmentRange(const VersionedInventory *record, const StationID &departureStation,
+                                 const StationID &arrivalStation, int &l, int &r);
+
+        template<class Visitor>
+        static int forEachSeatBlock(DailyTickets *daily, const TrainID &trainID, const Date &date, Visitor visit) {
+            return daily->seatMap.forEachInRange(SeatBlockKey(trainID, date, 0),
+                                                 SeatBlockKey(trainID, date, std::numeric_limits<int>::max()), visit);
+        }
     };
 }
 
@@ -1,4 +1,6 @@
 #include "TrainScheduler.h"
+#include "DataStructure/DeltaCodec.h"
+#include "DataStructure/IndexOrder.h"
 
 // 列车调度类，储存单个列车信息
 
@@ -10,6 +12,7 @@ namespace trainsys {
     TrainScheduler::TrainScheduler() {
         this->passingStationNum = 0;
         this->seatNum = 0;
+        this->durationSum[0] = this->priceSum[0] = 0;
     }
 
     /**
@@ -29,10 +32,13 @@ namespace trainsys {
         if (this->passingStationNum >= MAX_PASSING_STATION_NUMBER) {
             throw std::runtime_error("Station array is full");
         }
-        this->stations[this->passingStationNum] = station;
-        this->duration[this->passingStationNum] = 0;
-        this->price[this->passingStationNum] = 0;
+        int n = this->passingStationNum;
+        this->stations[n] = station;
+        // 新的一段运行时间和票价为0，前缀和与上一站相同
+        this->durationSum[n] = n > 0 ? this->durationSum[n - 1] : 0;
+        this->priceSum[n] = n > 0 ? this->priceSum[n - 1] : 0;
         this->passingStationNum++;
+        insertStationIndex(n);
     }
 
     /**
@@ -52,18 +58,21 @@ namespace trainsys {
         if (this->passingStationNum >= MAX_PASSING_STATION_NUMBER) {
             throw std::runtime_error("Station array is full");
         }
+        if (i == this->passingStationNum) {
+            addStation(station);
+            return;
+        }
         
-        // 将i及其后面的元素后移一位
+        // 将i及其后面的元素后移一位；新插入的一段为0，前缀和整体后移即可
         for (int j = this->passingStationNum; j > i; j--) {
             this->stations[j] = this->stations[j - 1];
-            this->duration[j] = this->duration[j - 1];
-            this->price[j] = this->price[j - 1];
+            this->durationSum[j] = this->durationSum[j - 1];
+            this->priceSum[j] = this->priceSum[j - 1];
         }
         
         this->stations[i] = station;
-        this->duration[i] = 0;  // 新插入站点的运行时间初始化为0
-        this->price[i] = 0;     // 新插入站点的票价初始化为0
         this->passingStationNum++;
+        insertStationIndex(i);
     }
 
     /**
@@ -76,12 +85,18 @@ namespace trainsys {
         if (i < 0 || i >= this->passingStationNum) {
             throw std::runtime_error("Invalid station index");
         }
+        removeStationIndex(i);
         
-        // 将i后面的元素前移一位
+        // 将i后面的元素前移一位；第i段被删去，其后各站的前缀和减去这一段
+        int durationDelta = 0, priceDelta = 0;
+        if (i + 1 < this->passingStationNum) {
+            durationDelta = this->durationSum[i + 1] - this->durationSum[i];
+            priceDelta = this->priceSum[i + 1] - this->priceSum[i];
+        }
         for (int j = i; j < this->passingStationNum - 1; j++) {
             this->stations[j] = this->stations[j + 1];
-            this->duration[j] = this->duration[j + 1];
-            this->price[j] = this->price[j + 1];
+            this->durationSum[j] = this->durationSum[j + 1] - durationDelta;
+            this->priceSum[j] = this->priceSum[j + 1] - priceDelta;
         }
         this->passingStationNum--;
     }
@@ -89,15 +104,12 @@ namespace trainsys {
     /**
      * @brief 查找指定站点的索引
      * @param stationID 要查找的站点ID
-     * @return 返回站点的索引，如果未找到则返回-1
+     * @return 返回站点的索引，如果未找到则返回-1；站点出现多次时返回第一次出现的索引
+     * @note 在按站点ID排序的查找表上二分查找，循环次数只取决于站点数量，
+     *       每步用条件传送代替分支，不会因预测失败而停顿
      */
-    int TrainScheduler::findStation(const StationID &stationID) {
-        for (int i = 0; i < this->passingStationNum; i++) {
-            if (this->stations[i] == stationID) {
-                return i;
-            }
-        }
-        return -1;  // 未找到返回-1
+    int TrainScheduler::findStation(const StationID &stationID) const {
+        return findInIndexOrder(this->stations, this->stationOrder, this->passingStationNum, stationID);
     }
 
     /**
@@ -107,8 +119,8 @@ namespace trainsys {
     void TrainScheduler::traverseStation() {
         for (int i = 0; i < this->passingStationNum; i++) {
             std::cout << "Station " << i << ": " << this->stations[i] 
-                      << ", Duration: " << this->duration[i]
-                      << ", Price: " << this->price[i] << std::endl;
+                      << ", Duration: " << getDuration(i)
+                      << ", Price: " << getPrice(i) << std::endl;
         }
     }
 
@@ -126,8 +138,8 @@ namespace trainsys {
      * @note price[i]表示从第i站到第i+1站的票价
      */
     void TrainScheduler::setPrice(const int price[]) {
-        for (int i = 0; i < this->passingStationNum - 1; i++) {
-            this->price[i] = price[i];
+        for (int i = 1; i < this->passingStationNum; i++) {
+            this->priceSum[i] = this->priceSum[i - 1] + price[i - 1];
         }
     }
 
@@ -137,8 +149,8 @@ namespace trainsys {
      * @note duration[i]表示从第i站到第i+1站的运行时间
      */
     void TrainScheduler::setDuration(const int duration[]) {
-        for (int i = 0; i < this->passingStationNum - 1; i++) {
-            this->duration[i] = duration[i];
+        for (int i = 1; i < this->passingStationNum; i++) {
+            this->durationSum[i] = this->durationSum[i - 1] + duration[i - 1];
         }
     }
 
@@ -190,27 +202,57 @@ namespace trainsys {
     /**
      * @brief 获取指定索引的运行时间
      * @param i 站点索引（0-based）
-     * @return 返回从第i站到第i+1站的运行时间
+     * @return 返回从第i站到第i+1站的运行时间，i为终点站时返回0
      * @throw std::runtime_error 当索引无效时抛出异常
      */
     int TrainScheduler::getDuration(int i) const {
         if (i < 0 || i >= this->passingStationNum) {
             throw std::runtime_error("Invalid duration index");
         }
-        return this->duration[i];
+        return i + 1 < this->passingStationNum ? this->durationSum[i + 1] - this->durationSum[i] : 0;
     }
 
     /**
      * @brief 获取指定索引的票价
      * @param i 站点索引（0-based）
-     * @return 返回从第i站到第i+1站的票价
+     * @return 返回从第i站到第i+1站的票价，i为终点站时返回0
      * @throw std::runtime_error 当索引无效时抛出异常
      */
     int TrainScheduler::getPrice(int i) const {
         if (i < 0 || i >= this->passingStationNum) {
             throw std::runtime_error("Invalid price index");
         }
-        return this->price[i];
+        return i + 1 < this->passingStationNum ? this->priceSum[i + 1] - this->priceSum[i] : 0;
+    }
+
+    /**
+     * @brief 获取两站之间的总运行时间
+     * @param from 出发站索引（0-based）
+     * @param to 到达站索引（0-based），不小于from
+     * @return 返回从第from站到第to站途经各段运行时间之和
+     * @throw std::runtime_error 当索引无效时抛出异常
+     * @note 由前缀和相减得到，时间复杂度为O(1)
+     */
+    int TrainScheduler::getDuration(int from, int to) const {
+        if (from < 0 || from > to || to >= this->passingStationNum) {
+            throw std::runtime_error("Invalid duration range");
+        }
+        return this->durationSum[to] - this->durationSum[from];
+    }
+
+    /**
+     * @brief 获取两站之间的总票价
+     * @param from 出发站索引（0-based）
+     * @param to 到达站索引（0-based），不小于from
+     * @return 返回从第from站到第to站途经各段票价之和
+     * @throw std::runtime_error 当索引无效时抛出异常
+     * @note 由前缀和相减得到，时间复杂度为O(1)
+     */
+    int TrainScheduler::getPrice(int from, int to) const {
+        if (from < 0 || from > to || to >= this->passingStationNum) {
+            throw std::runtime_error("Invalid price range");
+        }
+        return this->priceSum[to] - this->priceSum[from];
     }
 
     /**
@@ -237,7 +279,7 @@ namespace trainsys {
      */
     void TrainScheduler::getDuration(int *duration) const {
         for (int i = 0; i < this->passingStationNum; i++) {
-            duration[i] = this->duration[i];
+            duration[i] = getDuration(i);
         }
     }
 
@@ -251,7 +293,7 @@ namespace trainsys {
      */
     void TrainScheduler::getPrice(int *price) const {
         for (int i = 0; i < this->passingStationNum; i++) {
-            price[i] = this->price[i];
+            price[i] = getPrice(i);
         }
     }
 
@@ -301,11 +343,286 @@ namespace trainsys {
         for (int i = 0; i < trainScheduler.passingStationNum; i++) {
             os << "  " << i + 1 << ". " << trainScheduler.stations[i];
             if (i < trainScheduler.passingStationNum - 1) {
-                os << " -> Duration: " << trainScheduler.duration[i]
-                   << ", Price: " << trainScheduler.price[i];
+                os << " -> Duration: " << trainScheduler.getDuration(i)
+                   << ", Price: " << trainScheduler.getPrice(i);
             }
             os << "\n";
         }
         return os;
     }
+
+    /**
+     * @brief 计算编码长度的上界
+     * @param stationNum 站点数量
+     * @return 返回stationNum个站点的调度信息编码后可能的最大长度
+     * @note 座位数和站点数是变长整数，至多VARINT_MAX_LENGTH字节；每个站点另占STATION_RECORD_BYTES字节
+     */
+    int TrainScheduler::serializedSizeBound(int stationNum) {
+        return 2 + MAX_STRING_LENGTH + VARINT_MAX_LENGTH * 2 + STATION_RECORD_BYTES * stationNum;
+    }
+
+    /**
+     * @brief 将调度信息编码为紧凑格式
+     * @param buffer 输出缓冲区，长度不小于serializedSizeBound(getPassingStationNum())
+     * @return 返回编码长度
+     * @note 
+     * - 格式见TrainSchedulerView，只写入实际经过的站点，与MAX_PASSING_STATION_NUMBER无关
+     * - 站点查找表和前缀和原样写入，视图不必解码即可查找站点、计算区间和
+     */
+    int TrainScheduler::serialize(char *buffer) const {
+        int idLength = 0;
+        while (idLength < MAX_STRING_LENGTH - 1 && this->trainID.index[idLength] != '\0') {
+            idLength++;
+        }
+        int n = this->passingStationNum;
+        char *p = buffer;
+        *p++ = static_cast<char>(SERIAL_VERSION);
+        *p++ = static_cast<char>(idLength);
+        memcpy(p, this->trainID.index, idLength);
+        p += idLength;
+        p += varintEncode(zigzagEncode(this->seatNum), p);
+        p += varintEncode(zigzagEncode(n), p);
+        memcpy(p, this->stations, n * sizeof(StationID));
+        p += n * sizeof(StationID);
+        memcpy(p, this->stationOrder, n);
+        p += n;
+        memcpy(p, this->durationSum, n * sizeof(int));
+        p += n * sizeof(int);
+        memcpy(p, this->priceSum, n * sizeof(int));
+        p += n * sizeof(int);
+        return p - buffer;
+    }
+
+    /**
+     * @brief 将刚插入的第i站加入查找表
+     * @param i 新站点的索引，调用前stations和passingStationNum已更新
+     * @note 原来下标不小于i的站点后移了一位，表中的下标相应加一
+     */
+    void TrainScheduler::insertStationIndex(int i) {
+        int j = this->passingStationNum - 1;
+        for (int k = 0; k < j; k++) {
+            if (this->stationOrder[k] >= i) {
+                this->stationOrder[k]++;
+            }
+        }
+        // 插入排序：下标只是辅助键，保证同一站点出现多次时先找到靠前的一次
+        for (; j > 0; j--) {
+            int prev = this->stationOrder[j - 1];
+            if (this->stations[prev] < this->stations[i] || (this->stations[prev] == this->stations[i] && prev < i)) {
+                break;
+            }
+            this->stationOrder[j] = static_cast<unsigned char>(prev);
+        }
+        this->stationOrder[j] = static_cast<unsigned char>(i);
+    }
+
+    /**
+     * @brief 将即将删除的第i站移出查找表
+     * @param i 要删除的站点索引，调用时stations和passingStationNum尚未更新
+     * @note 下标大于i的站点将前移一位，表中的下标相应减一
+     */
+    void TrainScheduler::removeStationIndex(int i) {
+        int j = 0;
+        for (int k = 0; k < this->passingStationNum; k++) {
+            int index = this->stationOrder[k];
+            if (index == i) {
+                continue;
+            }
+            this->stationOrder[j++] = static_cast<unsigned char>(index > i ? index - 1 : index);
+        }
+    }
+
+    /**
+     * @brief 从p处读出一个zigzag变长整数，并将p移到其后
+     * @throw std::runtime_error 当数据在end之前被截断时抛出异常
+     */
+    static int readVarint(const char *&p, const char *end) {
+        unsigned value;
+        int length = varintDecode(p, end, value);
+        if (length == 0) {
+            throw std::runtime_error("Corrupted scheduler record");
+        }
+        p += length;
+        return zigzagDecode(value);
+    }
+
+    /**
+     * @brief 读出p处的一个int，p不必对齐
+     */
+    static int loadInt(const char *p) {
+        int value;
+        memcpy(&value, p, sizeof(int));
+        return value;
+    }
+
+    /**
+     * @brief 在编码后的调度信息上建立视图
+     * @param data 编码数据的起始地址
+     * @param length 编码长度
+     * @throw std::runtime_error 当格式版本不符、数据不完整或站点查找表越界时抛出异常
+     * @note 只解码座位数和站点数，检查各部分的长度和查找表中的下标，不复制数据
+     */
+    TrainSchedulerView::TrainSchedulerView(const char *data, int length) {
+        if (length < 2 || static_cast<unsigned char>(data[0]) != TrainScheduler::SERIAL_VERSION) {
+            throw std::runtime_error("Unsupported scheduler record");
+        }
+        this->trainIDLength = static_cast<unsigned char>(data[1]);
+        if (this->trainIDLength >= MAX_STRING_LENGTH || length < 2 + this->trainIDLength) {
+            throw std::runtime_error("Corrupted scheduler record");
+        }
+        const char *end = data + length;
+        this->trainID = data + 2;
+        const char *p = this->trainID + this->trainIDLength;
+        this->seatNum = readVarint(p, end);
+        this->passingStationNum = readVarint(p, end);
+        int n = this->passingStationNum;
+        if (n < 0 || n > MAX_PASSING_STATION_NUMBER || end - p != n * TrainScheduler::STATION_RECORD_BYTES) {
+            throw std::runtime_error("Corrupted scheduler record");
+        }
+        this->stationBegin = p;
+        this->orderBegin = reinterpret_cast<const unsigned char *>(this->stationBegin + n * sizeof(StationID));
+        this->durationSumBegin = reinterpret_cast<const char *>(this->orderBegin + n);
+        this->priceSumBegin = this->durationSumBegin + n * sizeof(int);
+        for (int i = 0; i < n; i++) {
+            if (this->orderBegin[i] >= n) {
+                throw std::runtime_error("Corrupted scheduler record");
+            }
+        }
+    }
+
+    /**
+     * @brief 获取列车ID
+     * @return 返回列车ID的副本
+     */
+    TrainID TrainSchedulerView::getTrainID() const {
+        char name[MAX_STRING_LENGTH] = {};
+        memcpy(name, this->trainID, this->trainIDLength);
+        return TrainID(name);
+    }
+
+    /**
+     * @brief 获取座位数
+     */
+    int TrainSchedulerView::getSeatNum() const {
+        return this->seatNum;
+    }
+
+    /**
+     * @brief 获取经过的站点数量
+     */
+    int TrainSchedulerView::getPassingStationNum() const {
+        return this->passingStationNum;
+    }
+
+    /**
+     * @brief 读出所有站点ID
+     * @param stations 输出数组，长度不小于getPassingStationNum()
+     */
+    void TrainSchedulerView::getStations(StationID *stations) const {
+        memcpy(stations, this->stationBegin, this->passingStationNum * sizeof(StationID));
+    }
+
+    /**
+     * @brief 读出各段运行时间
+     * @param duration 输出数组，长度不小于getPassingStationNum() - 1
+     */
+    void TrainSchedulerView::getDuration(int *duration) const {
+        for (int i = 0; i + 1 < this->passingStationNum; i++) {
+            duration[i] = prefixSum(this->durationSumBegin, i + 1) - prefixSum(this->durationSumBegin, i);
+        }
+    }
+
+    /**
+     * @brief 读出各段票价
+     * @param price 输出数组，长度不小于getPassingStationNum() - 1
+     */
+    void TrainSchedulerView::getPrice(int *price) const {
+        for (int i = 0; i + 1 < this->passingStationNum; i++) {
+            price[i] = prefixSum(this->priceSumBegin, i + 1) - prefixSum(this->priceSumBegin, i);
+        }
+    }
+
+    /**
+     * @brief 查找指定站点的索引
+     * @param stationID 要查找的站点ID
+     * @return 返回站点第一次出现的索引，如果未找到则返回-1
+     * @note 在记录中的站点查找表上二分，时间复杂度为O(log n)，做法同findInIndexOrder
+     */
+    int TrainSchedulerView::findStation(const StationID &stationID) const {
+        int n = this->passingStationNum;
+        if (n == 0) {
+            return -1;
+        }
+        const unsigned char *base = this->orderBegin;
+        while (n > 1) {
+            int half = n / 2;
+            base += station(base[half - 1]) < stationID ? half : 0;
+            n -= half;
+        }
+        return station(*base) == stationID ? *base : -1;
+    }
+
+    /**
+     * @brief 获取两站之间的总运行时间
+     * @param from 出发站索引（0-based）
+     * @param to 到达站索引（0-based），不小于from
+     * @throw std::runtime_error 当索引无效时抛出异常
+     * @note 前缀和相减，时间复杂度为O(1)
+     */
+    int TrainSchedulerView::getDuration(int from, int to) const {
+        if (from < 0 || from > to || to >= this->passingStationNum) {
+            throw std::runtime_error("Invalid duration range");
+        }
+        return prefixSum(this->durationSumBegin, to) - prefixSum(this->durationSumBegin, from);
+    }
+
+    /**
+     * @brief 获取两站之间的总票价
+     * @param from 出发站索引（0-based）
+     * @param to 到达站索引（0-based），不小于from
+     * @throw std::runtime_error 当索引无效时抛出异常
+     * @note 前缀和相减，时间复杂度为O(1)
+     */
+    int TrainSchedulerView::getPrice(int from, int to) const {
+        if (from < 0 || from > to || to >= this->passingStationNum) {
+            throw std::runtime_error("Invalid price range");
+        }
+        return prefixSum(this->priceSumBegin, to) - prefixSum(this->priceSumBegin, from);
+    }
+
+    /**
+     * @brief 展开为TrainScheduler
+     * @return 返回调度信息的副本，站点查找表随站点的加入重建
+     * @throw std::runtime_error 当站点数量超过MAX_PASSING_STATION_NUMBER时抛出异常
+     */
+    TrainScheduler TrainSchedulerView::toScheduler() const {
+        TrainScheduler scheduler;
+        scheduler.setTrainID(getTrainID());
+        scheduler.setSeatNumber(this->seatNum);
+        for (int i = 0; i < this->passingStationNum; i++) {
+            scheduler.addStation(station(i));
+        }
+        int duration[MAX_PASSING_STATION_NUMBER], price[MAX_PASSING_STATION_NUMBER];
+        getDuration(duration);
+        getPrice(price);
+        scheduler.setDuration(duration);
+        scheduler.setPrice(price);
+        return scheduler;
+    }
+
+    /**
+     * @brief 读出第i站的站点ID
+     */
+    StationID TrainSchedulerView::station(int i) const {
+        StationID value;
+        memcpy(&value, this->stationBegin + i * sizeof(StationID), sizeof(StationID));
+        return value;
+    }
+
+    /**
+     * @brief 读出从p开始的前缀和数组的第i项
+     */
+    int TrainSchedulerView::prefixSum(const char *p, int i) {
+        return loadInt(p + i * sizeof(int));
+    }
 }
@@ -3,6 +3,7 @@
 
 #include "Utils.h"
 #include "DataStructure/List.h"
+#include "DataStructure/IndexOrder.h"
 
 namespace trainsys {
     class TrainScheduler {
@@ -11,10 +12,21 @@ namespace trainsys {
         int seatNum;
         int passingStationNum;
         StationID stations[MAX_PASSING_STATION_NUMBER];
-        int duration[MAX_PASSING_STATION_NUMBER];
-        int price[MAX_PASSING_STATION_NUMBER];
+        // 运行时间和票价只存前缀和：durationSum[i]、priceSum[i]为从第0站到第i站的运行时间和票价，
+        // 第i段的值是相邻两项之差
+        int durationSum[MAX_PASSING_STATION_NUMBER];
+        int priceSum[MAX_PASSING_STATION_NUMBER];
+        // 站点的有序下标表，见IndexOrder.h，findStation在其上二分查找
+        unsigned char stationOrder[MAX_PASSING_STATION_NUMBER];
+        static_assert(MAX_PASSING_STATION_NUMBER <= 256, "station indices must fit in unsigned char");
 
     public:
+        // 紧凑编码的格式版本，写在编码的第一个字节；版本1的站点、运行时间和票价都是变长整数，见SchedulerManager的迁移
+        static const int SERIAL_VERSION = 2;
+
+        // 编码中每个站点占的字节数：站点ID、查找表中的一个下标、运行时间和票价的前缀和各一项
+        static const int STATION_RECORD_BYTES = sizeof(StationID) + 1 + 2 * sizeof(int);
+
         TrainScheduler();
 
         ~TrainScheduler();
@@ -25,7 +37,7 @@ namespace trainsys {
 
         void removeStation(int i);
 
-        int findStation(const StationID &station);
+        int findStation(const StationID &station) const;
 
         void traverseStation();
 
@@ -55,6 +67,10 @@ namespace trainsys {
 
         int getPrice(int i) const;
 
+        int getDuration(int from, int to) const;
+
+        int getPrice(int from, int to) const;
+
         bool operator ==(const TrainScheduler &rhs) const;
 
         bool operator !=(const TrainScheduler &rhs) const;
@@ -62,6 +78,63 @@ namespace trainsys {
         bool operator <(const TrainScheduler &rhs) const;
 
         friend std::ostream &operator <<(std::ostream &os, const TrainScheduler &trainScheduler);
+
+        // stationNum个站点的调度信息编码后长度的上界
+        static int serializedSizeBound(int stationNum);
+
+        // 按TrainSchedulerView说明的格式编码到buffer，返回编码长度；buffer至少要有serializedSizeBound字节
+        int serialize(char *buffer) const;
+
+    private:
+        void insertStationIndex(int i);
+
+        void removeStationIndex(int i);
+    };
+
+    // TrainScheduler紧凑编码的只读视图，直接在编码后的字节上读取，不复制数据，也不展开成定长数组
+    // 编码依次为：格式版本（1字节）、车次名长度（1字节）、车次名、座位数、站点数（zigzag变长整数），
+    // 之后是只含实际站点的四个定长数组：各站点ID、站点的有序下标表（每项1字节，见IndexOrder.h）、
+    // 运行时间的前缀和、票价的前缀和，整数按本机字节序存放，不要求对齐
+    // 查找站点在下标表上二分，O(log n)；区间的运行时间和票价由前缀和相减，O(1)
+    class TrainSchedulerView {
+    private:
+        const char *trainID;
+        const char *stationBegin;
+        const unsigned char *orderBegin;
+        const char *durationSumBegin, *priceSumBegin;
+        int trainIDLength;
+        int seatNum;
+        int passingStationNum;
+
+    public:
+        // 只检查编码的长度和下标表，不复制数据；视图在data被释放或改写之前有效
+        // @throw std::runtime_error 版本不符或数据不完整时抛出异常
+        TrainSchedulerView(const char *data, int length);
+
+        TrainID getTrainID() const;
+
+        int getSeatNum() const;
+
+        int getPassingStationNum() const;
+
+        void getStations(StationID *stations) const;
+
+        void getDuration(int *duration) const;
+
+        void getPrice(int *price) const;
+
+        int findStation(const StationID &station) const;
+
+        int getDuration(int from, int to) const;
+
+        int getPrice(int from, int to) const;
+
+        TrainScheduler toScheduler() const;
+
+    private:
+        StationID station(int i) const;
+
+        static int prefixSum(const char *p, int i);
     };
 }
 
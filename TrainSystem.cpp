@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <cstring>
+#include <vector>
 
 namespace trainsys {
     UserInfo currentUser;
@@ -12,7 +13,6 @@ namespace trainsys {
     PrioritizedWaitingList *waitingList;
     TripManager *tripManager;
     StationManager *stationManager;
-    RedBlackTree<String, StationID> stationNameToIDMapping;
 
     void addTrainScheduler(const TrainID &trainID, int seatNum, int passingStationNumber,
                            const StationID *stations, const int *duration, const int *price) {
@@ -31,6 +31,29 @@ namespace trainsys {
         /* Question */
     }
 
+    void releaseTicketRange(const TrainID *trainIDs, int n, const Date &dateFrom, const Date &dateTo) {
+        if (currentUser.privilege < ADMIN_PRIVILEGE) {
+            std::cout << "Permission denied." << std::endl;
+            return;
+        }
+        if (dateTo < dateFrom) {
+            std::cout << "Invalid date range." << std::endl;
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (!schedulerManager->existScheduler(trainIDs[i])) {
+                std::cout << "Train not found: " << trainIDs[i] << std::endl;
+                return;
+            }
+        }
+
+        // 放票只需各车次的站点、运行时间和票价，直接读记录文件上的视图，不展开成TrainScheduler
+        std::vector<TrainSchedulerView> schedulers;
+        for (int i = 0; i < n; ++i) schedulers.push_back(schedulerManager->viewScheduler(trainIDs[i]));
+        ticketManager->releaseRange(schedulers.data(), n, dateFrom, dateTo);
+        std::cout << "Tickets released." << std::endl;
+    }
+
     int queryRemainingTicket(const TrainID &trainID, const Date &date, const StationID &departureStation) {
         /* Question */
     }
@@ -127,4 +150,83 @@ namespace trainsys {
         userManager->modifyUserPrivilege(userID, newPrivilege);
         std::cout << "Modification succeeded." << std::endl;
     }
+
+    void addStation(const StationID stationID, const char *stationName) {
+        if (currentUser.privilege < ADMIN_PRIVILEGE) {
+            std::cout << "Permission denied." << std::endl;
+            return;
+        }
+        if (stationID < 0 || stationID >= MAX_STATIONID || stationManager->existStation(stationID)) {
+            std::cout << "Invalid station ID." << std::endl;
+            return;
+        }
+        if (stationName[0] == '\0' || strlen(stationName) > MAX_STATIONNAME_LEN
+            || stationManager->existStationName(stationName)) {
+            std::cout << "Invalid station name." << std::endl;
+            return;
+        }
+
+        stationManager->addStation(stationID, stationName);
+        std::cout << "Station added." << std::endl;
+    }
+
+    void renameStation(const StationID stationID, const char *newName) {
+        if (currentUser.privilege < ADMIN_PRIVILEGE) {
+            std::cout << "Permission denied." << std::endl;
+            return;
+        }
+        if (!stationManager->existStation(stationID)) {
+            std::cout << "Station not found." << std::endl;
+            return;
+        }
+        if (newName[0] == '\0' || strlen(newName) > MAX_STATIONNAME_LEN || stationManager->existStationName(newName)) {
+            std::cout << "Invalid station name." << std::endl;
+            return;
+        }
+
+        stationManager->renameStation(stationID, newName);
+        std::cout << "Station renamed." << std::endl;
+    }
+
+    void removeStation(const StationID stationID) {
+        if (currentUser.privilege < ADMIN_PRIVILEGE) {
+            std::cout << "Permission denied." << std::endl;
+            return;
+        }
+        if (!stationManager->existStation(stationID)) {
+            std::cout << "Station not found." << std::endl;
+            return;
+        }
+        if (schedulerManager->referencesStation(stationID)) {
+            std::cout << "Station in use." << std::endl;
+            return;
+        }
+
+        stationManager->removeStation(stationID);
+        railwayGraph->removeStation(stationID);
+        std::cout << "Station removed." << std::endl;
+    }
+
+    void searchStation(const char *text, int count) {
+        if (count <= 0) return;
+        if (count > MAX_STATIONID) count = MAX_STATIONID;
+        // 先按前缀补全，不足count个时用编辑距离相近的站名补齐
+        StationID result[MAX_STATIONID], fuzzy[MAX_STATIONID];
+        int found = stationManager->completeStationName(text, result, count);
+        if (found < count) {
+            int fuzzyCount = stationManager->fuzzyFindStation(text, STATION_FUZZY_DISTANCE, fuzzy, count);
+            for (int i = 0; i < fuzzyCount && found < count; ++i) {
+                bool duplicated = false;
+                for (int j = 0; j < found && !duplicated; ++j) duplicated = result[j] == fuzzy[i];
+                if (!duplicated) result[found++] = fuzzy[i];
+            }
+        }
+        if (found == 0) {
+            std::cout << "Station not found." << std::endl;
+            return;
+        }
+        for (int i = 0; i < found; ++i) {
+            std::cout << stationManager->getStationName(result[i]) << " " << result[i] << std::endl;
+        }
+    }
 } // namespace trainsys
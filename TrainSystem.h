@@ -10,7 +10,6 @@
 #include "SchedulerManager.h"
 #include "StationManager.h"
 #include "WaitingList.h"
-#include "DataStructure/RedBlackTree.h"
 
 namespace trainsys {
     void addTrainScheduler(const TrainID &trainID, int seatNum, int passingStationNumber,
@@ -22,6 +21,8 @@ namespace trainsys {
 
     void expireTicket(const TrainID &trainID, const Date &date);
 
+    void releaseTicketRange(const TrainID *trainIDs, int n, const Date &dateFrom, const Date &dateTo);
+
     int queryRemainingTicket(const TrainID &trainID, const Date &date, const StationID &departureStation);
 
     void queryMyTicket();
@@ -45,6 +46,14 @@ namespace trainsys {
     void modifyUserPassword(const UserID userID, const char *password);
 
     void modifyUserPrivilege(const UserID userID, int newPrivilege);
+
+    void addStation(const StationID stationID, const char *stationName);
+
+    void renameStation(const StationID stationID, const char *newName);
+
+    void removeStation(const StationID stationID);
+
+    void searchStation(const char *text, int count);
 }
 
 #endif
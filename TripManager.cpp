@@ -1,9 +1,83 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 #include "TripManager.h"
 #include "DataStructure/List.h"
+#include "DataStructure/FormatVersion.h"
 
 namespace trainsys {
+    namespace {
+        // 版本1的行程记录：日期按月、日两个int存放，只用于迁移
+        struct LegacyDate {
+            int mon;
+            int mday;
+        };
+
+        struct LegacyTripInfo {
+            TrainID trainID;
+            StationID departureStation;
+            StationID arrivalStation;
+            int ticketNumber;
+            int duration;
+            int price;
+            LegacyDate date;
+
+            TripInfo upgrade() const {
+                return TripInfo(trainID, departureStation, arrivalStation, ticketNumber, duration, price,
+                                Date(date.mon, date.mday));
+            }
+
+            // 只为满足B+树的接口，迁移时按升级后的记录重新排序
+            bool operator ==(const LegacyTripInfo &rhs) const { return upgrade() == rhs.upgrade(); }
+
+            bool operator <(const LegacyTripInfo &rhs) const { return upgrade() < rhs.upgrade(); }
+        };
+
+        typedef BPlusTree<UserID, TripInfo> TripTree;
+    }
+
     TripManager::TripManager(const std::string &filename)
-        : tripInfo(filename) {
+        : tripInfo(upgradeFile(filename), true) {
+    }
+
+    // 旧数据先整体转换成新树filename_migrated并刷盘，写入新版本号后再改名覆盖旧树；
+    // 改名中途崩溃时版本号已是新的，重新打开时把剩下的文件改完；版本号写入前崩溃则丢弃新树重新转换
+    const std::string &TripManager::upgradeFile(const std::string &filename) {
+        std::string migrated = filename + "_migrated";
+        int version = readFormatVersion(filename);
+        if (TripTree::exists(migrated)) {
+            if (version == FORMAT_VERSION) {
+                TripTree::rename(migrated, filename);
+                syncDirectoryOf(filename);
+                return filename;
+            }
+            TripTree::destroy(migrated);
+        }
+        if (version == FORMAT_VERSION) return filename;
+        if (!TripTree::exists(filename)) {
+            writeFormatVersion(filename, FORMAT_VERSION);
+            return filename;
+        }
+        if (version != 0) throw std::runtime_error("Unsupported trip file version");
+
+        std::vector<Pair<UserID, TripInfo> > entries;
+        {
+            BPlusTree<UserID, LegacyTripInfo> legacy(filename, true);
+            legacy.forEachEntry([&entries](const UserID &userID, const LegacyTripInfo &trip) {
+                entries.push_back(Pair<UserID, TripInfo>(userID, trip.upgrade()));
+            });
+        }
+        std::sort(entries.begin(), entries.end(), TripTree::entryLess);
+        {
+            TripTree upgraded(migrated, true);
+            upgraded.bulkLoad(entries.data(), static_cast<int>(entries.size()));
+        }
+        TripTree::sync(migrated);
+        syncDirectoryOf(migrated);
+        writeFormatVersion(filename, FORMAT_VERSION);
+        TripTree::rename(migrated, filename);
+        syncDirectoryOf(filename);
+        return filename;
     }
 
     void TripManager::addTrip(const UserID &userID, const TripInfo &trip) {
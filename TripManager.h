@@ -6,8 +6,12 @@
 #include "TripInfo.h"
 
 namespace trainsys {
+    // 行程文件的格式版本记在filename_version中；没有版本文件的已有数据是版本1（日期按月、日存放），
+    // 构造时转换成当前版本
     class TripManager {
     private:
+        static const int FORMAT_VERSION = 2;
+
         BPlusTree<UserID, TripInfo> tripInfo;
 
     public:
@@ -20,7 +24,16 @@ namespace trainsys {
 
         seqList<TripInfo> queryTrip(const UserID &userID);
 
+        // 分页遍历用户的行程，visit收到的引用只在回调期间有效，不复制整个历史
+        template<class Visitor>
+        int queryTrip(const UserID &userID, Visitor visit, int offset = 0, int limit = -1) {
+            return tripInfo.forEach(userID, visit, offset, limit);
+        }
+
         void removeTrip(const UserID &userID, const TripInfo &trip);
+
+    private:
+        static const std::string &upgradeFile(const std::string &filename);
     };
 } // namespace trainsys 
 
@@ -1,7 +1,8 @@
 #include "UserManager.h"
 
 namespace trainsys {
-    UserManager::UserManager(const char *filename): userInfoTable(filename) {
+    UserManager::UserManager(const char *filename): userInfoTable(filename, USER_CACHE_CAPACITY, USER_NEGATIVE_CACHE_CAPACITY) {
+        userInfoTable.setWriteBack(true, USER_CACHE_FLUSH_THRESHOLD, USER_CACHE_FLUSH_INTERVAL);
     }
 
     void UserManager::insertUser(const UserID &userID, const char *username, const char* password, int privilege) {
@@ -21,18 +22,15 @@ namespace trainsys {
     }
 
     void UserManager::modifyUserPrivilege(const UserID& userID, int newPrivilege) {
-        UserInfo info = findUser(userID);
-        removeUser(userID);
-        insertUser(userID, info.username, info.password, newPrivilege);
+        userInfoTable.update(userID, [newPrivilege](UserInfo &info) { info.privilege = newPrivilege; });
     }
 
     void UserManager::modifyUserPassword(const UserID& userID, const char* newPassword) {
-        UserInfo info = findUser(userID);
         int len = strlen(newPassword);
         if (len > MAX_PASSWORD_LEN) len = MAX_PASSWORD_LEN;
-        memcpy(info.password, newPassword, len);
-        info.password[len] = '\0';
-        removeUser(userID);
-        insertUser(userID, info.username, info.password, info.privilege);
+        userInfoTable.update(userID, [newPassword, len](UserInfo &info) {
+            memcpy(info.password, newPassword, len);
+            info.password[len] = '\0';
+        });
     }
 } // namespace trainsys
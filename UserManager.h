@@ -5,12 +5,13 @@
 #include "UserInfo.h"
 #include "DataStructure/List.h"
 #include "DataStructure/BPlusTree.h"
-#include "DataStructure/CachedBPlusTree.h"
+#include "DataStructure/HashTable.h"
+#include "DataStructure/ShardedCachedBPlusTree.h"
 
 namespace trainsys {
     class UserManager {
     private:
-        CachedBPlusTree<UserID, UserInfo> userInfoTable;
+        ShardedCachedBPlusTree<UserID, UserInfo, USER_TABLE_SHARDS> userInfoTable;
 
     public:
         UserManager(const char *filename);
@@ -14,11 +14,23 @@ namespace trainsys {
 
     const int MAX_STATIONID = 1000;
     const int MAX_STATIONNAME_LEN = 30;
+    const int STATION_FUZZY_DISTANCE = 2; // 站名模糊查找允许的最大编辑距离
 
     const int ADMIN_PRIVILEGE = 10;
 
     const int BUSY_STATE_TRESHOLD = 1;
 
+    const int USER_CACHE_CAPACITY = 4096;
+    const int USER_NEGATIVE_CACHE_CAPACITY = 1024;
+    const int USER_CACHE_FLUSH_THRESHOLD = 256;
+    const int USER_CACHE_FLUSH_INTERVAL = 1000; // 毫秒
+    const int USER_TABLE_SHARDS = 8;
+
+    const int TICKET_INVENTORY_SHARD_COUNT = 16;
+    const int TICKET_HOT_THRESHOLD = 8; // 访问次数达到该值的车次日期进入热层，修改改为延迟写回
+    const int TICKET_HOT_CAPACITY = 4096;
+    const int TICKET_FLUSH_INTERVAL = 200; // 毫秒，热层修改写回的最长间隔
+
     struct String;
 
     using UserID = long long;
@@ -51,27 +63,27 @@ namespace trainsys {
         }
 
         friend bool operator>(const String &lhs, const String &rhs) {
-            return std::string(lhs.index) > std::string(rhs.index);
+            return strcmp(lhs.index, rhs.index) > 0;
         }
 
         friend bool operator>=(const String &lhs, const String &rhs) {
-            return std::string(lhs.index) >= std::string(rhs.index);
+            return strcmp(lhs.index, rhs.index) >= 0;
         }
 
         friend bool operator<(const String &lhs, const String &rhs) {
-            return std::string(lhs.index) < std::string(rhs.index);
+            return strcmp(lhs.index, rhs.index) < 0;
         }
 
         friend bool operator<=(const String &lhs, const String &rhs) {
-            return std::string(lhs.index) <= std::string(rhs.index);
+            return strcmp(lhs.index, rhs.index) <= 0;
         }
 
         friend bool operator==(const String &lhs, const String &rhs) {
-            return std::string(lhs.index) == std::string(rhs.index);
+            return strcmp(lhs.index, rhs.index) == 0;
         }
 
         friend bool operator!=(const String &lhs, const String &rhs) {
-            return std::string(lhs.index) != std::string(rhs.index);
+            return strcmp(lhs.index, rhs.index) != 0;
         }
 
         friend std::ostream &operator<<(std::ostream &os, const String &obj) {
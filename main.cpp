@@ -2,6 +2,8 @@
 #include "CommandParser.h"
 #include "Utils.h"
 
+#include <filesystem>
+
 namespace trainsys {
     extern UserInfo currentUser;
     extern UserManager *userManager;
@@ -13,7 +15,13 @@ namespace trainsys {
     extern StationManager *stationManager;
 
     void init() {
-        stationManager = new StationManager("station.txt");
+        // station.txt只在第一次启动、二进制目录还不存在时编译成station.dat；之后运行期间的增删改
+        // 都合并进station.dat，不再用station.txt覆盖。要按修改后的station.txt重建，需先删除station.dat及其日志
+        std::error_code catalogError;
+        if (!std::filesystem::exists("station.dat", catalogError)) {
+            StationManager::compileCatalog("station.txt", "station.dat");
+        }
+        stationManager = new StationManager("station.dat");
         userManager = new UserManager("user.dat");
         schedulerManager = new SchedulerManager("scheduler.dat");
         ticketManager = new TicketManager("ticket.dat");
@@ -46,5 +54,6 @@ int main() {
     delete trainsys::ticketManager;
     delete trainsys::waitingList;
     delete trainsys::tripManager;
+    delete trainsys::stationManager;
     return 0;
 }
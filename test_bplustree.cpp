@@ -5,8 +5,13 @@
 #include <algorithm>
 #include <random>
 #include <filesystem>
+#include <thread>
+#include <chrono>
 #include <Windows.h>
 #include "DataStructure/BPlusTree.h"
+#include "DataStructure/CachedBPlusTree.h"
+#include "DataStructure/HashTable.h"
+#include "DataStructure/ShardedCachedBPlusTree.h"
 
 using namespace trainsys;
 using namespace std;
@@ -335,6 +340,620 @@ void testPersistence() {
     }
 }
 
+void testForEachPaging() {
+    cout << "\n=== 测试分页遍历 ===" << endl;
+    
+    try {
+        std::filesystem::remove("test_page_treeNodeFile");
+        std::filesystem::remove("test_page_leafFile");
+    } catch (...) {}
+    
+    BPlusTree<int, int> tree("test_page");
+    
+    // 同一键的值跨越多个叶子
+    for (int i = 0; i < 350; i++) {
+        tree.insert(7, i);
+    }
+    tree.insert(6, -1);
+    tree.insert(8, -1);
+    
+    int count = 0, sum = 0;
+    assert(tree.forEach(7, [&](const int &value) { count++, sum += value; }) == 350);
+    assert(count == 350 && sum == 349 * 350 / 2);
+    cout << "✓ 遍历跨叶子的全部值" << endl;
+    
+    int expected = 120;
+    bool ordered = true;
+    count = tree.forEach(7, [&](const int &value) { ordered = ordered && value == expected++; }, 120, 100);
+    assert(count == 100 && ordered);
+    cout << "✓ offset/limit分页正确" << endl;
+    
+    count = tree.forEach(7, [](const int &value) { return value < 9; });
+    assert(count == 10);
+    cout << "✓ 回调返回false时提前结束" << endl;
+    
+    auto page = tree.find(7, 340, 50);
+    assert(page.length() == 10 && page.visit(0) == 340);
+    assert(tree.forEach(9, [](const int &) {}) == 0);
+    assert(tree.findFirst(9) == 0);
+    cout << "✓ 分页find与空结果正常" << endl;
+}
+
+void testColdLeafCompression() {
+    cout << "\n=== 测试冷叶子压缩 ===" << endl;
+    
+    for (string name : {"test_cold", "test_raw"}) {
+        try {
+            std::filesystem::remove(name + "_treeNodeFile");
+            std::filesystem::remove(name + "_leafFile");
+            std::filesystem::remove(name + "_leafIndexFile");
+        } catch (...) {}
+    }
+    
+    const int testSize = 3000;
+    {
+        BPlusTree<long long, long long> raw("test_raw");
+        BPlusTree<long long, long long> tree("test_cold", true);
+        for (int i = 0; i < testSize; i++) {
+            raw.insert(i / 3, 1000000 + i);
+            tree.insert(i / 3, 1000000 + i);
+        }
+        tree.compressColdLeaves(0);
+        for (int i = 0; i < testSize; i += 7) {
+            assert(tree.contains(i / 3));
+        }
+        cout << "✓ 全部叶子压缩后查找正常" << endl;
+        
+        // 压缩过的叶子被修改后重新以原样记录存放
+        for (int i = 0; i < testSize; i += 10) {
+            tree.modify(i / 3, 1000000 + i, 2000000 + i);
+        }
+        assert(tree.size() == testSize);
+        assert(tree.find(0).length() == 3);
+        cout << "✓ 修改压缩叶子正常" << endl;
+        tree.compressColdLeaves(0);
+    }
+    
+    auto rawSize = std::filesystem::file_size("test_raw_leafFile");
+    auto coldSize = std::filesystem::file_size("test_cold_leafFile");
+    assert(coldSize * 2 < rawSize);
+    cout << "✓ 叶子文件大小 " << rawSize << " -> " << coldSize << endl;
+    
+    {
+        BPlusTree<long long, long long> tree("test_cold", true);
+        assert(tree.size() == testSize);
+        for (int i = 0; i < testSize; i++) {
+            long long expected = (i % 10 == 0 ? 2000000 : 1000000) + i;
+            bool found = false;
+            tree.forEach(i / 3, [&](const long long &value) { found = found || value == expected; });
+            assert(found);
+        }
+        tree.compressColdLeaves(0);
+        for (int i = 0; i < testSize; i += 2) {
+            tree.removeFirst(i / 3);
+        }
+        assert(tree.size() == testSize / 2);
+        cout << "✓ 重新打开后数据完整" << endl;
+    }
+}
+
+void testColdLeafRecovery() {
+    cout << "\n=== 测试压缩模式的索引恢复 ===" << endl;
+    
+    auto removeTree = [](const string &name) {
+        for (const char *suffix : {"_treeNodeFile", "_leafFile", "_leafIndexFile", "_leafFile.tmp",
+                                   "_leafIndexFile.commit", "_leafFile.link"}) {
+            std::filesystem::remove(name + suffix);
+        }
+    };
+    removeTree("test_recover");
+    
+    // 非压缩模式建立的树以压缩模式打开时按定长排布重建索引
+    {
+        BPlusTree<int, int> tree("test_recover");
+        for (int i = 0; i < 500; i++) {
+            tree.insert(i, i * 2);
+        }
+    }
+    {
+        BPlusTree<int, int> tree("test_recover", true);
+        assert(tree.size() == 500);
+        for (int i = 0; i < 500; i++) {
+            assert(tree.findFirst(i) == i * 2);
+        }
+        tree.compressColdLeaves(0);
+    }
+    cout << "✓ 非压缩的树以压缩模式打开后数据完整" << endl;
+    
+    // 压缩模式的索引丢失时不能清空数据，而是报错
+    auto leafSize = std::filesystem::file_size("test_recover_leafFile");
+    std::filesystem::rename("test_recover_leafIndexFile", "test_recover_leafIndexFile.bak");
+    bool thrown = false;
+    try {
+        BPlusTree<int, int> tree("test_recover", true);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(std::filesystem::file_size("test_recover_leafFile") == leafSize);
+    std::filesystem::rename("test_recover_leafIndexFile.bak", "test_recover_leafIndexFile");
+    cout << "✓ 索引丢失时报错，叶子文件保持原样" << endl;
+    
+    // 压缩整理在提交文件写出后中途退出：重新打开时完成替换
+    std::filesystem::copy_file("test_recover_leafFile", "test_recover_leafFile.tmp");
+    std::filesystem::copy_file("test_recover_leafIndexFile", "test_recover_leafIndexFile.commit");
+    std::filesystem::resize_file("test_recover_leafFile", 8);
+    {
+        BPlusTree<int, int> tree("test_recover", true);
+        assert(tree.size() == 500 && tree.findFirst(499) == 998);
+    }
+    assert(!std::filesystem::exists("test_recover_leafFile.tmp"));
+    assert(!std::filesystem::exists("test_recover_leafIndexFile.commit"));
+    cout << "✓ 中途退出的压缩整理在重新打开时完成" << endl;
+    
+    // 冷叶子为主的树只改少量叶子时，关闭时不重写叶子文件
+    std::filesystem::create_hard_link("test_recover_leafFile", "test_recover_leafFile.link");
+    {
+        BPlusTree<int, int> tree("test_recover", true);
+        tree.insert(250, -1);
+    }
+    assert(std::filesystem::equivalent("test_recover_leafFile", "test_recover_leafFile.link"));
+    {
+        BPlusTree<int, int> tree("test_recover", true);
+        assert(tree.size() == 501 && tree.find(250).length() == 2);
+        for (int i = 0; i < 500; i += 3) {
+            tree.removeFirst(i);
+        }
+        // 之后只反复写最后一个叶子，前面被改写成原样记录的叶子变冷，值得重新压缩
+        for (int i = 0; i < BPlusTree<int, int>::DEFAULT_COLD_WRITE_DISTANCE; i++) {
+            tree.insert(600, i);
+            tree.remove(600, i);
+        }
+    }
+    assert(!std::filesystem::equivalent("test_recover_leafFile", "test_recover_leafFile.link"));
+    {
+        BPlusTree<int, int> tree("test_recover", true);
+        assert(tree.size() == 501 - 167 && !tree.contains(3) && tree.findFirst(4) == 8);
+    }
+    removeTree("test_recover");
+    cout << "✓ 少量修改时不重写叶子文件，改写过的叶子变冷后才重写" << endl;
+}
+
+void testRangeScan() {
+    cout << "\n=== 测试范围遍历 ===" << endl;
+    
+    try {
+        std::filesystem::remove("test_range_treeNodeFile");
+        std::filesystem::remove("test_range_leafFile");
+    } catch (...) {}
+    
+    BPlusTree<int, int> tree("test_range");
+    
+    // 乱序插入，每个键两个值，范围跨越多个叶子
+    for (int i = 0; i < 1000; i++) {
+        int key = (i * 7919) % 1000;
+        tree.insert(key, key * 2);
+        tree.insert(key, key * 2 + 1);
+    }
+    
+    int expectedKey = 200, count = 0;
+    bool ordered = true;
+    assert(tree.forEachInRange(200, 599, [&](const int &key, const int &value) {
+        ordered = ordered && key == expectedKey && value == key * 2 + count % 2;
+        if (++count % 2 == 0) expectedKey++;
+    }) == 800);
+    assert(ordered && expectedKey == 600);
+    cout << "✓ 按键升序遍历闭区间内的键值对" << endl;
+    
+    count = tree.forEachInRange(-5, 2000, [](const int &key, const int &) { return key < 9; });
+    assert(count == 19);
+    assert(tree.forEachInRange(500, 499, [](const int &, const int &) {}) == 0);
+    assert(tree.forEachInRange(1000, 2000, [](const int &, const int &) {}) == 0);
+    assert(tree.forEachInRange(999, 999, [](const int &, const int &) {}) == 2);
+    cout << "✓ 提前结束、空区间与边界正确" << endl;
+}
+
+void testUpdateFirst() {
+    cout << "\n=== 测试就地修改 ===" << endl;
+    
+    try {
+        std::filesystem::remove("test_update_treeNodeFile");
+        std::filesystem::remove("test_update_leafFile");
+    } catch (...) {}
+    
+    {
+        BPlusTree<int, long long> tree("test_update");
+        for (int i = 0; i < 1000; i++) {
+            tree.insert(i, (long long) i * 10);
+        }
+        for (int i = 0; i < 1000; i += 3) {
+            assert(tree.updateFirst(i, [](long long &value) { value += 1; }));
+        }
+        assert(!tree.updateFirst(1000, [](long long &value) { value = -1; }));
+        assert(tree.updateFirst(5, [](long long &value) { value = -1; return false; }));
+        assert(tree.findFirst(5) == 50);
+    }
+    
+    BPlusTree<int, long long> tree("test_update");
+    for (int i = 0; i < 1000; i++) {
+        assert(tree.findFirst(i) == (long long) i * 10 + (i % 3 == 0));
+    }
+    tree.remove(999, 9991);
+    assert(!tree.contains(999) && tree.size() == 999);
+    cout << "✓ 修改写回叶子，重新打开后仍在，返回false时不写回" << endl;
+}
+
+void testBulkLoad() {
+    cout << "\n=== 测试批量建树 ===" << endl;
+    
+    // 小阶数让树有多层
+    using SmallTree = BPlusTree<int, int, 8, 8>;
+    SmallTree::destroy("test_bulk");
+    assert(!SmallTree::exists("test_bulk"));
+    
+    // 每个键两个值
+    const int n = 5000;
+    vector<Pair<int, int>> entries;
+    for (int i = 0; i < n; i++) {
+        entries.push_back(Pair<int, int>(i / 2, i));
+    }
+    {
+        SmallTree tree("test_bulk");
+        tree.insert(-1, -1);
+        tree.bulkLoad(entries.data(), n);
+        assert(tree.size() == n && !tree.contains(-1));
+        for (int key = 0; key < n / 2; key++) {
+            seqList<int> values = tree.find(key);
+            assert(values.length() == 2 && values.visit(0) == 2 * key && values.visit(1) == 2 * key + 1);
+        }
+        int expected = 0;
+        assert(tree.forEachInRange(0, n, [&](const int &, const int &value) { assert(value == expected++); }) == n);
+        cout << "✓ 批量建树后查找和范围遍历正确" << endl;
+        
+        // 建好的树可以继续插入和删除
+        for (int i = 0; i < n; i += 2) {
+            tree.remove(i / 2, i);
+        }
+        for (int i = 0; i < 1000; i++) {
+            tree.insert(n + i, i);
+        }
+        assert(tree.size() == n / 2 + 1000);
+        
+        bool threw = false;
+        try {
+            tree.bulkLoad(entries.data() + 1, 2);
+            Pair<int, int> unsorted[2] = {Pair<int, int>(2, 0), Pair<int, int>(1, 0)};
+            tree.bulkLoad(unsorted, 2);
+        } catch (const invalid_argument &) {
+            threw = true;
+        }
+        assert(threw && tree.size() == 2);
+        tree.bulkLoad(entries.data(), n);
+    }
+    
+    assert(SmallTree::exists("test_bulk"));
+    {
+        SmallTree tree("test_bulk");
+        assert(tree.size() == n && tree.findFirst(n / 2 - 1) == n - 2);
+        for (int i = 1; i < n; i += 2) {
+            tree.remove(i / 2, i);
+        }
+        assert(tree.size() == n / 2 && tree.forEachInRange(0, n, [](const int &, const int &) {}) == n / 2);
+    }
+    SmallTree::destroy("test_bulk");
+    assert(!SmallTree::exists("test_bulk"));
+    cout << "✓ 建好的树可继续增删，重新打开后仍在，destroy删除所有文件" << endl;
+}
+
+// 没有比较运算符的值类型，只能用于映射模式
+struct UniqueRecord {
+    int payload;
+    long long stamp;
+};
+
+void testUniqueKey() {
+    cout << "\n=== 测试映射模式 ===" << endl;
+
+    using UniqueTree = BPlusTree<int, UniqueRecord, 8, 8, true>;
+    UniqueTree::destroy("test_unique");
+    {
+        UniqueTree tree("test_unique");
+        const int n = 2000;
+        for (int i = 0; i < n; i++) {
+            tree.insert(i, UniqueRecord{i, 0});
+        }
+        // 已有的键被覆盖而不是再插入一条
+        for (int i = 0; i < n; i += 3) {
+            tree.insert(i, UniqueRecord{-i, 1});
+        }
+        assert(tree.size() == n);
+        for (int i = 0; i < n; i++) {
+            seqList<UniqueRecord> values = tree.find(i);
+            assert(values.length() == 1);
+            assert(values.visit(0).payload == (i % 3 == 0 ? -i : i) && values.visit(0).stamp == (i % 3 == 0));
+        }
+        cout << "✓ 插入已有的键时覆盖原值" << endl;
+
+        // 删除只看键，传入的值与存储的不同也能删掉
+        for (int i = 0; i < n; i += 2) {
+            tree.remove(i, UniqueRecord{12345, 6789});
+        }
+        assert(tree.size() == n / 2);
+        for (int i = 0; i < n; i++) {
+            assert(tree.contains(i) == (i % 2 == 1));
+        }
+        assert(tree.updateFirst(1, [](UniqueRecord &record) { record.stamp = 42; }));
+        assert(tree.findFirst(1).stamp == 42);
+        cout << "✓ 删除和就地修改只按键比较" << endl;
+
+        Pair<int, UniqueRecord> duplicated[2] = {Pair<int, UniqueRecord>(1, UniqueRecord{1, 0}),
+                                                 Pair<int, UniqueRecord>(1, UniqueRecord{2, 0})};
+        bool threw = false;
+        try {
+            tree.bulkLoad(duplicated, 2);
+        } catch (const invalid_argument &) {
+            threw = true;
+        }
+        assert(threw && tree.size() == n / 2);
+        cout << "✓ 批量建树拒绝重复的键" << endl;
+    }
+    UniqueTree::destroy("test_unique");
+}
+
+// 删除名为name的CachedBPlusTree留下的所有文件
+void destroyCachedTree(const string &name) {
+    BPlusTree<int, int>::destroy(name);
+    std::filesystem::remove(name + "_hotKeys");
+}
+
+void testCachedWriteBack() {
+    cout << "\n=== 测试缓存写回 ===" << endl;
+    
+    using Cached = CachedBPlusTree<int, int, HashTable>;
+    destroyCachedTree("test_wb");
+    {
+        Cached tree("test_wb", 4);
+        for (int i = 0; i < 8; i++) {
+            tree.insert(i, i);
+        }
+    }
+    // 去掉热键文件，重新打开时缓存为空，键只在磁盘上
+    std::filesystem::remove("test_wb_hotKeys");
+    {
+        Cached tree("test_wb", 4);
+        tree.setWriteBack(true, 100, 100000);
+        tree.insert(1, 10);
+        tree.insert(2, 20);
+        tree.insert(100, 1000);
+        assert(tree.find(1) == 10 && tree.getDirtyCount() == 3);
+        tree.flush();
+        assert(tree.getDirtyCount() == 0);
+    }
+    std::filesystem::remove("test_wb_hotKeys");
+    {
+        BPlusTree<int, int> raw("test_wb");
+        assert(raw.find(1).length() == 1 && raw.findFirst(1) == 10);
+        assert(raw.find(2).length() == 1 && raw.findFirst(2) == 20);
+        assert(raw.find(100).length() == 1 && raw.size() == 9);
+    }
+    cout << "✓ 写回时替换只在磁盘上的旧值，不留下重复记录" << endl;
+    
+    {
+        Cached tree("test_wb", 4);
+        tree.setWriteBack(true, 100, 50);
+        tree.insert(3, 30);
+        tree.remove(4);
+        assert(tree.getDirtyCount() == 2);
+        // 之后不再有修改，由后台线程按时写回
+        for (int i = 0; i < 100 && tree.getDirtyCount() > 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        assert(tree.getDirtyCount() == 0 && tree.find(3) == 30 && !tree.contains(4));
+        tree.setWriteBack(false);
+        tree.insert(200, 2000);
+    }
+    std::filesystem::remove("test_wb_hotKeys");
+    {
+        BPlusTree<int, int> raw("test_wb");
+        assert(raw.find(3).length() == 1 && raw.findFirst(3) == 30 && !raw.contains(4) && raw.contains(200));
+    }
+    destroyCachedTree("test_wb");
+    cout << "✓ 修改停止后脏项按时写回，关闭写回后恢复写穿透" << endl;
+}
+
+void testCachedLRU() {
+    cout << "\n=== 测试LRU缓存淘汰 ===" << endl;
+    
+    destroyCachedTree("test_lru");
+    {
+        CachedBPlusTree<int, int> tree("test_lru", 3);
+        for (int i = 1; i <= 3; i++) {
+            tree.insert(i, i * 10);
+        }
+        assert(tree.getCacheSize() == 3 && tree.getEvictionCount() == 0);
+        
+        // 访问1后1最新，再放入4时淘汰最久未访问的2
+        assert(tree.find(1) == 10);
+        tree.insert(4, 40);
+        assert(tree.getCacheSize() == 3 && tree.getEvictionCount() == 1);
+        long long misses = tree.getMissCount();
+        assert(tree.find(1) == 10 && tree.find(3) == 30 && tree.find(4) == 40);
+        assert(tree.getMissCount() == misses);
+        cout << "✓ 容量满时淘汰最久未访问的项，其余项仍命中" << endl;
+        
+        // 被淘汰的键从B+树重新读入，并挤出当前最久未访问的1
+        assert(tree.find(2) == 20 && tree.getMissCount() == misses + 1);
+        assert(tree.getEvictionCount() == 2);
+        assert(tree.find(1) == 10 && tree.getMissCount() == misses + 2);
+        cout << "✓ 淘汰的项未命中时从B+树读回" << endl;
+    }
+    destroyCachedTree("test_lru");
+}
+
+void testCachedNegative() {
+    cout << "\n=== 测试否定缓存 ===" << endl;
+    
+    destroyCachedTree("test_neg");
+    {
+        CachedBPlusTree<int, int, HashTable> tree("test_neg", 8, 2);
+        tree.insert(1, 10);
+        
+        // 不存在的键第一次查询访问B+树并记为否定项，之后直接命中
+        long long misses = tree.getMissCount();
+        assert(!tree.contains(5) && tree.getMissCount() == misses + 1 && tree.getNegativeSize() == 1);
+        assert(!tree.contains(5) && tree.getMissCount() == misses + 1 && tree.getNegativeHitCount() == 1);
+        cout << "✓ 不存在的键记为否定项，再次查询不访问B+树" << endl;
+        
+        // 插入后否定项失效
+        tree.insert(5, 50);
+        assert(tree.contains(5) && tree.find(5) == 50 && tree.getNegativeSize() == 0);
+        
+        // 删除后又记为否定项，否定项链表满时淘汰最旧的
+        tree.remove(5);
+        assert(!tree.contains(5) && tree.getNegativeSize() == 1);
+        assert(!tree.contains(6) && !tree.contains(7) && tree.getNegativeSize() == 2);
+        misses = tree.getMissCount();
+        assert(!tree.contains(5) && tree.getMissCount() == misses + 1);
+        cout << "✓ 插入使否定项失效，删除后重新记为否定项，容量满时淘汰" << endl;
+        
+        // 写回模式下同样失效，写回后键在磁盘上
+        tree.setWriteBack(true, 100, 0);
+        assert(!tree.contains(8));
+        tree.insert(8, 80);
+        assert(tree.find(8) == 80);
+    }
+    std::filesystem::remove("test_neg_hotKeys");
+    {
+        BPlusTree<int, int> raw("test_neg");
+        assert(raw.findFirst(8) == 80 && !raw.contains(5) && raw.size() == 2);
+    }
+    destroyCachedTree("test_neg");
+    cout << "✓ 写回模式下插入同样使否定项失效" << endl;
+}
+
+void testCachedWarmUp() {
+    cout << "\n=== 测试热键预读 ===" << endl;
+    
+    destroyCachedTree("test_warm");
+    {
+        CachedBPlusTree<int, int, HashTable> tree("test_warm", 16);
+        for (int i = 0; i < 100; i++) {
+            tree.insert(i, i * 2);
+        }
+        // 最后访问的16个键留在缓存中
+        for (int i = 50; i < 66; i++) {
+            assert(tree.find(i) == i * 2);
+        }
+    }
+    assert(std::filesystem::exists("test_warm_hotKeys"));
+    cout << "✓ 析构时热键写入文件" << endl;
+    
+    {
+        CachedBPlusTree<int, int, HashTable> tree("test_warm", 16);
+        tree.waitForWarmUp();
+        assert(!tree.isWarmingUp() && tree.getCacheSize() == 16);
+        long long misses = tree.getMissCount();
+        for (int i = 50; i < 66; i++) {
+            assert(tree.find(i) == i * 2);
+        }
+        assert(tree.getMissCount() == misses);
+        assert(tree.find(0) == 0 && tree.getMissCount() == misses + 1);
+    }
+    cout << "✓ 重新打开后预读线程读回热键，查询全部命中" << endl;
+    
+    {
+        // 预读期间的前台操作与预读线程互斥，结果与预读无关
+        CachedBPlusTree<int, int, HashTable> tree("test_warm", 16);
+        tree.insert(55, -1);
+        tree.remove(60);
+        assert(tree.find(55) == -1 && !tree.contains(60) && tree.find(70) == 140);
+        tree.waitForWarmUp();
+        assert(tree.find(55) == -1 && !tree.contains(60) && tree.find(51) == 102);
+    }
+    destroyCachedTree("test_warm");
+    cout << "✓ 预读期间的修改不被预读覆盖" << endl;
+}
+
+void destroyShardedTree(const string &name, int shardCount) {
+    destroyCachedTree(name);
+    for (int i = 0; i < shardCount; i++) {
+        destroyCachedTree(name + "_shard" + to_string(i));
+    }
+}
+
+void testShardedConcurrent() {
+    cout << "\n=== 测试分片缓存的并发访问 ===" << endl;
+    
+    using Sharded = ShardedCachedBPlusTree<int, int, 4>;
+    const int THREADS = 8, KEYS_PER_THREAD = 500, COUNTERS = 16, ROUNDS = 200;
+    destroyShardedTree("test_shard", 4);
+    {
+        Sharded tree("test_shard", 64, 16);
+        tree.setWriteBack(true, 32, 20);
+        for (int i = 0; i < COUNTERS; i++) {
+            tree.insert(-1 - i, 0);
+        }
+        vector<thread> workers;
+        for (int t = 0; t < THREADS; t++) {
+            workers.emplace_back([&tree, t]() {
+                // 各线程写自己的键，同时对公共计数器做读-改-写
+                for (int i = 0; i < KEYS_PER_THREAD; i++) {
+                    int key = t * KEYS_PER_THREAD + i;
+                    tree.insert(key, key * 3);
+                    assert(tree.find(key) == key * 3);
+                    if (i % 5 == 0) tree.remove(key);
+                }
+                for (int r = 0; r < ROUNDS; r++) {
+                    assert(tree.update(-1 - (r + t) % COUNTERS, [](int &value) { value++; }));
+                }
+            });
+        }
+        for (thread &worker : workers) worker.join();
+        
+        int total = 0;
+        for (int i = 0; i < COUNTERS; i++) {
+            total += tree.find(-1 - i);
+        }
+        assert(total == THREADS * ROUNDS);
+        assert(!tree.update(THREADS * KEYS_PER_THREAD, [](int &value) { value++; }));
+    }
+    cout << "✓ 多线程插入、删除和读-改-写不丢失修改" << endl;
+    
+    {
+        Sharded tree("test_shard", 64, 16);
+        for (int key = 0; key < THREADS * KEYS_PER_THREAD; key++) {
+            if (key % KEYS_PER_THREAD % 5 == 0) assert(!tree.contains(key));
+            else assert(tree.find(key) == key * 3);
+        }
+    }
+    destroyShardedTree("test_shard", 4);
+    cout << "✓ 重新打开后各分片的数据完整" << endl;
+    
+    // 未分片的旧文件在第一次打开时迁移到各分片
+    {
+        BPlusTree<int, int> old("test_shard");
+        for (int i = 0; i < 1000; i++) {
+            old.insert(i, i + 1);
+        }
+    }
+    {
+        Sharded tree("test_shard");
+        assert((!BPlusTree<int, int>::exists("test_shard")));
+        for (int i = 0; i < 1000; i++) {
+            assert(tree.find(i) == i + 1);
+        }
+        assert(!tree.contains(1000));
+    }
+    int migrated = 0;
+    for (int i = 0; i < 4; i++) {
+        BPlusTree<int, int> shard("test_shard_shard" + to_string(i));
+        migrated += shard.size();
+    }
+    assert(migrated == 1000);
+    destroyShardedTree("test_shard", 4);
+    cout << "✓ 未分片的旧数据迁移到各分片后删除旧文件" << endl;
+}
+
 int main() {
     // 设置控制台编码
     SetConsoleOutputCP(CP_UTF8);
@@ -354,6 +973,18 @@ int main() {
         testClearOperation();
         testEdgeCases();
         testPersistence();
+        testForEachPaging();
+        testColdLeafCompression();
+        testColdLeafRecovery();
+        testRangeScan();
+        testUpdateFirst();
+        testBulkLoad();
+        testUniqueKey();
+        testCachedLRU();
+        testCachedNegative();
+        testCachedWriteBack();
+        testCachedWarmUp();
+        testShardedConcurrent();
         
         cout << "\n🎉 所有测试通过！BPlusTree 实现正确。" << endl;
         
@@ -368,7 +999,12 @@ int main() {
             "test_string_treeNodeFile", "test_string_leafFile",
             "test_clear_treeNodeFile", "test_clear_leafFile",
             "test_edge_treeNodeFile", "test_edge_leafFile",
-            "test_persist_treeNodeFile", "test_persist_leafFile"
+            "test_persist_treeNodeFile", "test_persist_leafFile",
+            "test_page_treeNodeFile", "test_page_leafFile",
+            "test_cold_treeNodeFile", "test_cold_leafFile", "test_cold_leafIndexFile",
+            "test_raw_treeNodeFile", "test_raw_leafFile",
+            "test_range_treeNodeFile", "test_range_leafFile",
+            "test_update_treeNodeFile", "test_update_leafFile"
         };
         
         for (const auto& file : testFiles) {
@@ -0,0 +1,381 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <random>
+#include <Windows.h>
+#include "DataStructure/HashTable.h"
+#include <cstring>
+#include "DataStructure/PoolAllocator.h"
+#include "DataStructure/RedBlackTree.h"
+#include "DataStructure/EytzingerTable.h"
+#include "DataStructure/PerfectHash.h"
+#include "DataStructure/Trie.h"
+
+using namespace trainsys;
+using namespace std;
+
+void testHashTableRemove() {
+    cout << "=== 测试Robin Hood哈希表删除 ===" << endl;
+    
+    // 找出5个理想位置相同的键，插入后连成一段探测链
+    HashTable<int, int> table(16);
+    vector<int> cluster;
+    for (int key = 0; cluster.size() < 5; key++) {
+        if ((Hash<int>()(key) & 15) == 3) cluster.push_back(key);
+    }
+    for (int key : cluster) {
+        table.insert(DataType<int, int>(key, key * 10));
+    }
+    assert(table.length() == 5);
+    
+    // 删除链头和链中间的键，后面的键向前移动后仍能找到
+    table.remove(cluster[0]);
+    table.remove(cluster[2]);
+    assert(table.length() == 3);
+    assert(table.find(cluster[0]) == nullptr && table.find(cluster[2]) == nullptr);
+    for (int i : {1, 3, 4}) {
+        DataType<int, int> *found = table.find(cluster[i]);
+        assert(found != nullptr && found->value == cluster[i] * 10);
+    }
+    
+    // 删除不存在的键不影响其他键，重新插入后可以找到
+    table.remove(cluster[0]);
+    table.insert(DataType<int, int>(cluster[0], -1));
+    assert(table.length() == 4 && table.find(cluster[0])->value == -1);
+    cout << "✓ 删除后探测链上的键向前移动，仍能找到" << endl;
+    
+    // 随机插入删除，与std::set对照，中间经过多次扩容
+    mt19937 rng(7);
+    HashTable<int, int> big;
+    set<int> expected;
+    for (int i = 0; i < 20000; i++) {
+        int key = rng() % 4000;
+        if (rng() % 3 == 0) {
+            big.remove(key);
+            expected.erase(key);
+        } else {
+            big.insert(DataType<int, int>(key, key + 1));
+            expected.insert(key);
+        }
+        if (i % 1000 == 0) {
+            for (int k = 0; k < 4000; k++) {
+                DataType<int, int> *found = big.find(k);
+                assert((found != nullptr) == (expected.count(k) > 0));
+                assert(found == nullptr || found->value == k + 1);
+            }
+        }
+    }
+    assert(big.length() == static_cast<int>(expected.size()));
+    cout << "✓ 随机插入删除与std::set一致" << endl;
+}
+
+// 记录存活对象个数的值类型，用来确认红黑树析构时每个结点都被析构
+struct Tracked {
+    static int live;
+    int value;
+
+    Tracked(int value = 0) : value(value) { live++; }
+    Tracked(const Tracked &rhs) : value(rhs.value) { live++; }
+    Tracked &operator=(const Tracked &rhs) { value = rhs.value; return *this; }
+    ~Tracked() { live--; }
+};
+
+int Tracked::live = 0;
+
+// 统计分配、归还和整体释放次数的内存池，结点类型是红黑树的私有类型，计数放在模板外
+struct PoolCounters {
+    static int allocated, deallocated, released;
+
+    static void reset() { allocated = deallocated = released = 0; }
+};
+
+int PoolCounters::allocated = 0, PoolCounters::deallocated = 0, PoolCounters::released = 0;
+
+template<class T>
+class CountingPool : public PoolAllocator<T> {
+public:
+    T *allocate() { PoolCounters::allocated++; return PoolAllocator<T>::allocate(); }
+    void deallocate(T *p) { PoolCounters::deallocated++; PoolAllocator<T>::deallocate(p); }
+    void release() { PoolCounters::released++; PoolAllocator<T>::release(); }
+};
+
+void testPoolAllocator() {
+    cout << "\n=== 测试结点内存池 ===" << endl;
+    
+    struct Block {
+        char bytes[64];
+    };
+    
+    // 500个64字节的结点占用多个块，隔一个释放一个，释放的位置分布在各个块中
+    PoolAllocator<Block> pool;
+    vector<Block *> blocks;
+    for (int i = 0; i < 500; i++) {
+        blocks.push_back(pool.allocate());
+        memset(blocks.back()->bytes, i & 0xff, sizeof(Block));
+    }
+    assert(set<Block *>(blocks.begin(), blocks.end()).size() == blocks.size());
+    set<Block *> freed;
+    for (int i = 0; i < 500; i += 2) {
+        pool.deallocate(blocks[i]);
+        freed.insert(blocks[i]);
+    }
+    // 再分配时先用完空闲链表上的结点，后释放的先被复用
+    for (int i = 498; i >= 0; i -= 2) {
+        Block *reused = pool.allocate();
+        assert(reused == blocks[i]);
+        freed.erase(reused);
+    }
+    assert(freed.empty());
+    for (int i = 1; i < 500; i += 2) {
+        assert(blocks[i]->bytes[0] == static_cast<char>(i & 0xff));
+    }
+    Block *fresh = pool.allocate();
+    assert(find(blocks.begin(), blocks.end(), fresh) == blocks.end());
+    cout << "✓ 跨块释放的结点被按后进先出的顺序复用，空闲链表用完后才动用新位置" << endl;
+    
+    // release后整块归还，之后重新从新块分配
+    pool.release();
+    Block *afterRelease = pool.allocate();
+    assert(afterRelease != nullptr);
+    cout << "✓ release后内存池可以继续分配" << endl;
+    
+    // 析构时池中还有未归还的结点：值类型需要析构时逐个析构并归还，否则直接整块释放
+    PoolCounters::reset();
+    {
+        RedBlackTree<int, Tracked, CountingPool> tree;
+        for (int i = 0; i < 300; i++) {
+            tree.insert(DataType<int, Tracked>(i, Tracked(i)));
+        }
+        for (int i = 0; i < 300; i += 3) {
+            tree.remove(i);
+        }
+        assert(tree.find(4)->value.value == 4 && tree.find(3) == nullptr);
+        assert(Tracked::live == 200);
+    }
+    assert(Tracked::live == 0);
+    assert(PoolCounters::allocated == 300 && PoolCounters::deallocated == 300 && PoolCounters::released == 0);
+    cout << "✓ 值需要析构的红黑树析构时每个存活结点都被析构" << endl;
+    PoolCounters::reset();
+    {
+        RedBlackTree<int, int, CountingPool> tree;
+        for (int i = 0; i < 300; i++) {
+            tree.insert(DataType<int, int>(i, i * 2));
+        }
+        tree.remove(7);
+        assert(tree.find(8)->value == 16 && tree.find(7) == nullptr);
+    }
+    assert(PoolCounters::allocated == 300 && PoolCounters::deallocated == 1 && PoolCounters::released == 1);
+    {
+        RedBlackTree<int, int, NewAllocator> tree;
+        for (int i = 0; i < 300; i++) {
+            tree.insert(DataType<int, int>(i, i * 2));
+        }
+        for (int i = 0; i < 300; i += 2) {
+            tree.remove(i);
+        }
+        assert(tree.find(9)->value == 18 && tree.find(8) == nullptr);
+    }
+    cout << "✓ 平凡的结点在析构时整块释放，使用new/delete的分配器逐个释放" << endl;
+}
+
+void testEytzingerTable() {
+    cout << "\n=== 测试Eytzinger有序表 ===" << endl;
+    
+    // 持有数组的表不能被复制，否则两个对象会释放同一块内存
+    static_assert(!std::is_copy_constructible<EytzingerTable<int, int>>::value, "copyable");
+    static_assert(!std::is_copy_assignable<EytzingerTable<int, int>>::value, "copyable");
+    static_assert(!std::is_copy_constructible<HashTable<int, int>>::value, "copyable");
+    static_assert(!std::is_copy_assignable<HashTable<int, int>>::value, "copyable");
+    
+    // 各种大小的表上查找，包括层序数组最后几层不满的情况
+    mt19937 rng(11);
+    for (int n = 0; n <= 300; n++) {
+        EytzingerTable<int, int> table(1);
+        set<int> expected;
+        while (static_cast<int>(expected.size()) < n) {
+            int key = rng() % 1000;
+            table.insert(DataType<int, int>(key, -key));
+            expected.insert(key);
+        }
+        assert(table.length() == n);
+        for (int key = -1; key <= 1000; key++) {
+            DataType<int, int> *found = table.find(key);
+            assert((found != nullptr) == (expected.count(key) > 0));
+            assert(found == nullptr || found->value == -key);
+        }
+        if (n > 0) {
+            table.remove(*expected.begin());
+            assert(table.find(*expected.begin()) == nullptr && table.length() == n - 1);
+        }
+    }
+    cout << "✓ 各种大小的表上查找结果与std::set一致" << endl;
+    
+    // 通过find修改的值保存在有序数组中，之后的插入删除不会把它改回去
+    EytzingerTable<int, int> table;
+    for (int key = 0; key < 50; key++) {
+        table.insert(DataType<int, int>(key * 2, 0));
+    }
+    for (int key = 0; key < 100; key += 2) {
+        table.find(key)->value = key + 1;
+    }
+    table.insert(DataType<int, int>(1, -1));
+    table.remove(0);
+    for (int key = 2; key < 100; key += 2) {
+        assert(table.find(key)->value == key + 1);
+    }
+    assert(table.find(1)->value == -1 && table.find(0) == nullptr);
+    cout << "✓ 通过find修改的值在之后的插入删除后仍然有效" << endl;
+}
+
+void testPerfectHash() {
+    cout << "\n=== 测试最小完美哈希 ===" << endl;
+    
+    vector<string> names;
+    for (int i = 0; i < 1000; i++) {
+        names.push_back("station" + to_string(i * 7919 % 100003));
+    }
+    vector<const char *> keys;
+    for (const string &name : names) {
+        keys.push_back(name.c_str());
+    }
+    PerfectHash hash;
+    hash.build(keys.data(), keys.size());
+    assert(hash.size() == 1000 && hash.getBucketCount() == 250);
+    vector<bool> used(keys.size(), false);
+    for (const char *key : keys) {
+        int slot = hash(key);
+        assert(slot >= 0 && slot < static_cast<int>(keys.size()) && !used[slot]);
+        used[slot] = true;
+    }
+    cout << "✓ n个键一一映射到[0, n)" << endl;
+    
+    // 位移表和种子可以交给另一个对象直接使用
+    PerfectHash attached;
+    attached.attach(hash.size(), hash.getBucketCount(), hash.getSeed(), hash.getDisplacement());
+    for (const char *key : keys) {
+        assert(attached(key) == hash(key));
+    }
+    cout << "✓ attach后映射不变" << endl;
+    
+    // 有重复的键时抛出异常，之后仍可重建
+    vector<const char *> duplicated = {"a", "b", "c", "b"};
+    bool threw = false;
+    try {
+        hash.build(duplicated.data(), duplicated.size());
+    } catch (const invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+    hash.build(duplicated.data(), 3);
+    assert(hash.size() == 3 && hash("a") != hash("b") && hash("b") != hash("c") && hash("a") != hash("c"));
+    cout << "✓ 重复的键抛出invalid_argument" << endl;
+    
+    // 空集合：所有键都映射到-1
+    PerfectHash empty;
+    empty.build(keys.data(), 0);
+    assert(empty.size() == 0 && empty.getBucketCount() == 0 && empty("station0") == -1 && empty("") == -1);
+    hash.build(keys.data(), 0);
+    assert(hash("a") == -1);
+    cout << "✓ 空集合上的查询返回-1" << endl;
+}
+
+void testTrieComplete() {
+    cout << "\n=== 测试字典树补全 ===" << endl;
+    
+    Trie<int> trie;
+    trie.insert("beijing", 1, 50);
+    trie.insert("beijingnan", 2, 80);
+    trie.insert("beijingxi", 3, 30);
+    trie.insert("baoding", 4, 70);
+    trie.insert("shanghai", 5, 100);
+    assert(trie.size() == 5);
+    
+    int result[10];
+    assert(trie.complete("b", result, 10) == 4);
+    assert(result[0] == 2 && result[1] == 4 && result[2] == 1 && result[3] == 3);
+    assert(trie.complete("bei", result, 2) == 2 && result[0] == 2 && result[1] == 1);
+    assert(trie.complete("beijing", result, 10) == 3 && result[0] == 2);
+    assert(trie.complete("", result, 1) == 1 && result[0] == 5);
+    assert(trie.complete("x", result, 10) == 0 && trie.complete("b", result, 0) == 0);
+    cout << "✓ 按热度从高到低取前k个" << endl;
+    
+    // 热度变化和删除后次序随之改变
+    trie.addWeight("beijingxi", 100);
+    assert(trie.complete("bei", result, 10) == 3 && result[0] == 3 && result[1] == 2 && result[2] == 1);
+    trie.addWeight("beijingxi", -120);
+    assert(trie.complete("bei", result, 10) == 3 && result[2] == 3);
+    trie.remove("beijingnan");
+    assert(trie.size() == 4 && trie.complete("bei", result, 10) == 2 && result[0] == 1 && result[1] == 3);
+    int value;
+    assert(!trie.find("beijingnan", value) && trie.find("beijing", value) && value == 1);
+    // 覆盖时降低热度
+    trie.insert("baoding", 4, 1);
+    assert(trie.complete("b", result, 10) == 3 && result[0] == 1 && result[2] == 4);
+    cout << "✓ 修改热度、删除、覆盖后次序正确" << endl;
+}
+
+void testTrieFuzzy() {
+    cout << "\n=== 测试字典树模糊查找 ===" << endl;
+    
+    Trie<int> trie;
+    trie.insert("abc", 1, 1);
+    trie.insert("abd", 2, 5);
+    trie.insert("abcd", 3, 9);
+    trie.insert("xyz", 4, 100);
+    trie.insert("shanghai", 5, 0);
+    
+    int result[10];
+    assert(trie.fuzzyFind("abc", 0, result, 10) == 1 && result[0] == 1);
+    // 距离相同时热度高的在前
+    assert(trie.fuzzyFind("abc", 1, result, 10) == 3);
+    assert(result[0] == 1 && result[1] == 3 && result[2] == 2);
+    assert(trie.fuzzyFind("abc", 1, result, 2) == 2 && result[0] == 1 && result[1] == 3);
+    cout << "✓ 按距离从小到大、热度从高到低排列，最多k个" << endl;
+    
+    // 距离恰好为上限的键找得到，超过上限的找不到
+    assert(trie.fuzzyFind("shanghei", 1, result, 10) == 1 && result[0] == 5);
+    assert(trie.fuzzyFind("shangh", 1, result, 10) == 0);
+    assert(trie.fuzzyFind("shangh", 2, result, 10) == 1 && result[0] == 5);
+    assert(trie.fuzzyFind("xy", 1, result, 10) == 1 && result[0] == 4);
+    assert(trie.fuzzyFind("ab", 2, result, 10) == 3);
+    assert(trie.fuzzyFind("qqq", 2, result, 10) == 0);
+    assert(trie.fuzzyFind("abc", -1, result, 10) == 0 && trie.fuzzyFind("abc", 3, result, 0) == 0);
+    cout << "✓ 编辑距离上限严格生效" << endl;
+    
+    // 删除的键不再出现
+    trie.remove("abcd");
+    assert(trie.fuzzyFind("abc", 1, result, 10) == 2 && result[0] == 1 && result[1] == 2);
+    cout << "✓ 删除的键不再出现" << endl;
+}
+
+int main() {
+    // 设置控制台编码
+    SetConsoleOutputCP(CP_UTF8);
+    SetConsoleCP(CP_UTF8);
+    std::system("chcp 65001 > nul");
+    std::system("cls");
+    
+    cout << "开始数据结构测试...\n" << endl;
+    
+    try {
+        testHashTableRemove();
+        testPerfectHash();
+        testTrieComplete();
+        testTrieFuzzy();
+        testPoolAllocator();
+        testEytzingerTable();
+        
+        cout << "\n🎉 所有测试通过！" << endl;
+    } catch (const exception& e) {
+        cout << "❌ 测试失败: " << e.what() << endl;
+        return 1;
+    } catch (...) {
+        cout << "❌ 测试失败: 未知错误" << endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <stdexcept>
+#include <Windows.h>
+#include "DateTime.h"
+
+using namespace trainsys;
+using namespace std;
+
+// 调用f，断言它抛出std::invalid_argument
+template<class Func>
+void expectInvalid(Func f) {
+    bool thrown = false;
+    try {
+        f();
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void testDateArithmetic() {
+    cout << "=== 测试日期运算 ===" << endl;
+
+    Date newYearsEve("12-31");
+    assert(newYearsEve.mon() == 12 && newYearsEve.mday() == 31);
+    assert(string(newYearsEve + 1) == "01-01" && string(Date("01-01") - 1) == "12-31");
+    assert(string(Date("02-28") + 1) == "03-01" && string(Date("12-30") + 3) == "01-02");
+    assert(string(Date("03-01") + DAYS_PER_YEAR) == "03-01" && string(Date("01-05") - 400) == "12-01");
+    Date date("12-25");
+    date += 10;
+    assert(string(date) == "01-04");
+    date -= 4;
+    assert(string(date) == "12-31");
+    cout << "✓ 越过年末和年初时回绕到相邻一年的同一天" << endl;
+
+    expectInvalid([]() { Date("13-01"); });
+    expectInvalid([]() { Date("02-29"); });
+    expectInvalid([]() { Date("1-01"); });
+    expectInvalid([]() { Date("01-01x"); });
+    expectInvalid([]() { Date(4, 31); });
+    bool outOfRange = false;
+    try {
+        Date::ofDay(DAYS_PER_YEAR);
+    } catch (const std::out_of_range &) {
+        outOfRange = true;
+    }
+    assert(outOfRange);
+    cout << "✓ 非法日期在构造时报错" << endl;
+}
+
+void testTime() {
+    cout << "\n=== 测试时刻 ===" << endl;
+
+    Time time("23:59");
+    assert(time.hour() == 23 && time.min() == 59 && string(time) == "23:59");
+    assert(string(Time("00:00")) == "00:00");
+    expectInvalid([]() { Time("24:00"); });
+    expectInvalid([]() { Time("12:60"); });
+    expectInvalid([]() { Time("1:00"); });
+    expectInvalid([]() { Time("12-00"); });
+    expectInvalid([]() { Time("12:00:00"); });
+    expectInvalid([]() { Time(static_cast<const char *>(nullptr)); });
+    expectInvalid([]() { Time(0, 24, 1, 1); });
+    expectInvalid([]() { Time(0, 12, 30, 2); });
+    cout << "✓ 格式或取值非法的时刻在构造时报错" << endl;
+
+    // 12-31 23:00出发，运行两小时后到达01-01 01:00，时刻仍可比较和相减
+    Time departure(0, 23, 31, 12);
+    Time arrival = departure + 120;
+    assert(string(arrival.date()) == "01-01" && arrival.hour() == 1 && arrival.min() == 0);
+    assert(departure < arrival && arrival - departure == 120);
+    Time early = Time(30, 0, 1, 1) - 60;
+    assert(string(early.date()) == "12-31" && early.hour() == 23 && early.min() == 30);
+    cout << "✓ 跨年的时刻按日期规则回绕，比较和相减不受影响" << endl;
+}
+
+int main() {
+    // 设置控制台编码
+    SetConsoleOutputCP(CP_UTF8);
+    SetConsoleCP(CP_UTF8);
+    std::system("chcp 65001 > nul");
+    std::system("cls");
+
+    cout << "开始 DateTime 测试...\n" << endl;
+
+    try {
+        testDateArithmetic();
+        testTime();
+
+        cout << "\n🎉 所有测试通过！" << endl;
+    } catch (const exception& e) {
+        cout << "❌ 测试失败: " << e.what() << endl;
+        return 1;
+    } catch (...) {
+        cout << "❌ 测试失败: 未知错误" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,488 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <climits>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <Windows.h>
+#include "SchedulerManager.h"
+#include "DataStructure/BPlusTree.h"
+#include "DataStructure/DeltaCodec.h"
+
+using namespace trainsys;
+using namespace std;
+
+// 删除名为name的SchedulerManager留下的所有文件
+void destroySchedulerFiles(const string &name) {
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        if (entry.path().filename().string().rfind(name + "_", 0) == 0) std::filesystem::remove(entry.path());
+    }
+}
+
+// 与SchedulerManager::SchedulerSlot布局相同，用来直接改写B+树中记录的位置
+struct RawSlot {
+    long long offset;
+    int length;
+};
+
+typedef BPlusTree<TrainID, RawSlot, 100, 100, true> RawSlotTree;
+
+// 版本1之前B+树中直接存放的调度信息
+struct LegacyTrainScheduler {
+    TrainID trainID;
+    int seatNum;
+    int passingStationNum;
+    StationID stations[MAX_PASSING_STATION_NUMBER];
+    int duration[MAX_PASSING_STATION_NUMBER];
+    int price[MAX_PASSING_STATION_NUMBER];
+
+    bool operator ==(const LegacyTrainScheduler &rhs) const { return trainID == rhs.trainID; }
+
+    bool operator <(const LegacyTrainScheduler &rhs) const { return trainID < rhs.trainID; }
+};
+
+// 第i个车次有stationNum个站点，站点、运行时间和票价都由i决定
+void trainData(int i, int stationNum, StationID stations[], int duration[], int price[]) {
+    for (int j = 0; j < stationNum; j++) {
+        stations[j] = (i * 37 + j * 11) % 1000;
+    }
+    for (int j = 0; j + 1 < stationNum; j++) {
+        duration[j] = 10 + (i + j) % 50;
+        price[j] = 100 * (j + 1) + i;
+    }
+}
+
+void addTrain(SchedulerManager &manager, int i, int stationNum) {
+    StationID stations[MAX_PASSING_STATION_NUMBER];
+    int duration[MAX_PASSING_STATION_NUMBER] = {}, price[MAX_PASSING_STATION_NUMBER] = {};
+    trainData(i, stationNum, stations, duration, price);
+    manager.addScheduler(TrainID(("T" + to_string(i)).c_str()), 100 + i, stationNum, stations, duration, price);
+}
+
+void checkTrain(SchedulerManager &manager, int i, int stationNum) {
+    TrainID trainID(("T" + to_string(i)).c_str());
+    assert(manager.existScheduler(trainID));
+    TrainScheduler scheduler = manager.getScheduler(trainID);
+    TrainSchedulerView view = manager.viewScheduler(trainID);
+    assert(scheduler.getTrainID() == trainID && view.getTrainID() == trainID);
+    assert(scheduler.getSeatNum() == 100 + i && view.getSeatNum() == 100 + i);
+    assert(scheduler.getPassingStationNum() == stationNum && view.getPassingStationNum() == stationNum);
+    int totalDuration = 0, totalPrice = 0;
+    for (int j = 0; j < stationNum; j++) {
+        StationID station = (i * 37 + j * 11) % 1000;
+        assert(scheduler.getStation(j) == station);
+        assert(scheduler.findStation(station) == view.findStation(station));
+        assert(scheduler.getDuration(0, j) == totalDuration && view.getDuration(0, j) == totalDuration);
+        assert(scheduler.getPrice(0, j) == totalPrice && view.getPrice(0, j) == totalPrice);
+        if (j + 1 < stationNum) {
+            assert(scheduler.getDuration(j) == 10 + (i + j) % 50);
+            assert(scheduler.getPrice(j) == 100 * (j + 1) + i);
+            totalDuration += 10 + (i + j) % 50;
+            totalPrice += 100 * (j + 1) + i;
+        }
+    }
+}
+
+// 调用f，断言它抛出std::runtime_error
+template<class Func>
+void expectRuntimeError(Func f) {
+    bool thrown = false;
+    try {
+        f();
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void testRoundTrip() {
+    cout << "=== 测试调度信息的写入和读出 ===" << endl;
+
+    destroySchedulerFiles("test_scheduler");
+    {
+        SchedulerManager manager("test_scheduler");
+        for (int i = 0; i < 200; i++) {
+            addTrain(manager, i, 2 + i % (MAX_PASSING_STATION_NUMBER - 1));
+        }
+        for (int i = 0; i < 200; i++) {
+            checkTrain(manager, i, 2 + i % (MAX_PASSING_STATION_NUMBER - 1));
+        }
+    }
+    cout << "✓ 视图与展开后的TrainScheduler一致" << endl;
+
+    // 覆盖一半车次、删除一部分车次，旧记录超过一半后在析构时重写记录文件
+    {
+        SchedulerManager manager("test_scheduler");
+        for (int round = 0; round < 2; round++) {
+            for (int i = 0; i < 200; i += 2) {
+                addTrain(manager, i, MAX_PASSING_STATION_NUMBER);
+            }
+        }
+        for (int i = 1; i < 200; i += 4) {
+            manager.removeScheduler(TrainID(("T" + to_string(i)).c_str()));
+        }
+    }
+    {
+        SchedulerManager manager("test_scheduler");
+        for (int i = 0; i < 200; i++) {
+            if (i % 2 == 0) {
+                checkTrain(manager, i, MAX_PASSING_STATION_NUMBER);
+            } else if (i % 4 == 1) {
+                assert(!manager.existScheduler(TrainID(("T" + to_string(i)).c_str())));
+            } else {
+                checkTrain(manager, i, 2 + i % (MAX_PASSING_STATION_NUMBER - 1));
+            }
+        }
+        expectRuntimeError([&]() { manager.viewScheduler(TrainID("T1")); });
+    }
+    destroySchedulerFiles("test_scheduler");
+    cout << "✓ 覆盖、删除和重新打开后读出的调度信息正确" << endl;
+}
+
+void testReferencesStation() {
+    cout << "\n=== 测试站点是否被车次引用 ===" << endl;
+
+    destroySchedulerFiles("test_refs");
+    {
+        SchedulerManager manager("test_refs");
+        assert(!manager.referencesStation(0));
+        addTrain(manager, 1, 3);  // 站点37, 48, 59
+        addTrain(manager, 2, 2);  // 站点74, 85
+        for (StationID station : {37, 48, 59, 74, 85}) {
+            assert(manager.referencesStation(station));
+        }
+        assert(!manager.referencesStation(36) && !manager.referencesStation(60));
+        manager.removeScheduler(TrainID("T1"));
+        assert(!manager.referencesStation(48) && manager.referencesStation(85));
+    }
+    destroySchedulerFiles("test_refs");
+    cout << "✓ 只有仍存在的车次经过的站点被视为已引用" << endl;
+}
+
+void testTruncatedRecord() {
+    cout << "\n=== 测试截断的记录 ===" << endl;
+
+    // 编码的任何一个真前缀都不能建立视图
+    TrainScheduler scheduler;
+    scheduler.setTrainID(TrainID("K9"));
+    scheduler.setSeatNumber(300);
+    int duration[MAX_PASSING_STATION_NUMBER] = {}, price[MAX_PASSING_STATION_NUMBER] = {};
+    for (int i = 0; i < 5; i++) {
+        scheduler.addStation(200 - i * 40);
+        duration[i] = 1000 + i;
+        price[i] = 70000 + i;
+    }
+    scheduler.setDuration(duration);
+    scheduler.setPrice(price);
+    vector<char> buffer(TrainScheduler::serializedSizeBound(5));
+    int length = scheduler.serialize(buffer.data());
+    for (int prefix = 0; prefix < length; prefix++) {
+        expectRuntimeError([&]() { TrainSchedulerView(buffer.data(), prefix); });
+    }
+    TrainSchedulerView view(buffer.data(), length);
+    assert(view.getPrice(0, 4) == scheduler.getPrice(0, 4) && view.getDuration(1, 3) == scheduler.getDuration(1, 3));
+    // 站点查找表在两个前缀和之前，每站一个字节；越界的下标同样不能建立视图
+    char order = buffer[length - 45];
+    buffer[length - 45] = 5;
+    expectRuntimeError([&]() { TrainSchedulerView(buffer.data(), length); });
+    buffer[length - 45] = order;
+    cout << "✓ 截断的编码和越界的站点查找表在建立视图时被发现" << endl;
+
+    // 记录文件末尾的记录被截断，例如追加记录后还没落盘就崩溃
+    destroySchedulerFiles("test_truncated");
+    {
+        SchedulerManager manager("test_truncated");
+        addTrain(manager, 1, 4);
+        addTrain(manager, 2, 6);
+    }
+    std::filesystem::resize_file("test_truncated_records", std::filesystem::file_size("test_truncated_records") - 3);
+    {
+        SchedulerManager manager("test_truncated");
+        checkTrain(manager, 1, 4);
+        expectRuntimeError([&]() { manager.viewScheduler(TrainID("T2")); });
+        expectRuntimeError([&]() { manager.getScheduler(TrainID("T2")); });
+    }
+    destroySchedulerFiles("test_truncated");
+    cout << "✓ 超出记录文件的记录在读取时报错，其他记录仍可读取" << endl;
+}
+
+void testCorruptedSlot() {
+    cout << "\n=== 测试损坏的记录位置 ===" << endl;
+
+    destroySchedulerFiles("test_slot");
+    {
+        SchedulerManager manager("test_slot");
+        addTrain(manager, 1, 4);
+        addTrain(manager, 2, 6);
+    }
+    RawSlot valid;
+    {
+        RawSlotTree tree("test_slot");
+        assert(tree.forEach(TrainID("T2"), [&valid](const RawSlot &slot) { valid = slot; }, 0, 1) == 1);
+    }
+    long long fileSize = std::filesystem::file_size("test_slot_records");
+    RawSlot corrupted[] = {
+        {fileSize, 1},                     // 从文件末尾开始
+        {valid.offset, valid.length + 1},  // 越过文件末尾
+        {valid.offset, -1},                // 负长度
+        {valid.offset, valid.length - 1},  // 在文件内，但截掉了记录的最后一个字节
+        {0, valid.length},                 // 落在文件头中
+        {LLONG_MAX - 1, 2},                // 相加会溢出
+        {valid.offset + 1, valid.length - 1},  // 从记录中间开始
+    };
+    for (const RawSlot &slot : corrupted) {
+        {
+            RawSlotTree tree("test_slot");
+            tree.insert(TrainID("T2"), slot);
+        }
+        SchedulerManager manager("test_slot");
+        expectRuntimeError([&]() { manager.viewScheduler(TrainID("T2")); });
+        expectRuntimeError([&]() { manager.getScheduler(TrainID("T2")); });
+        checkTrain(manager, 1, 4);
+    }
+    {
+        RawSlotTree tree("test_slot");
+        tree.insert(TrainID("T2"), valid);
+    }
+    {
+        SchedulerManager manager("test_slot");
+        checkTrain(manager, 2, 6);
+    }
+    destroySchedulerFiles("test_slot");
+    cout << "✓ 越界或不完整的{offset, length}在读取时报错" << endl;
+}
+
+// 目录中名字以name + suffix开头的文件数
+int countFiles(const string &name, const string &suffix) {
+    int count = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        count += entry.path().filename().string().rfind(name + suffix, 0) == 0;
+    }
+    return count;
+}
+
+void testUpgrade() {
+    cout << "\n=== 测试旧版本数据的转换 ===" << endl;
+
+    // 版本1之前：只有B+树，其中直接存放定长的调度信息
+    destroySchedulerFiles("test_legacy");
+    {
+        BPlusTree<TrainID, LegacyTrainScheduler> legacy("test_legacy");
+        for (int i = 0; i < 50; i++) {
+            LegacyTrainScheduler scheduler = {};
+            scheduler.trainID = TrainID(("T" + to_string(i)).c_str());
+            scheduler.seatNum = 100 + i;
+            scheduler.passingStationNum = 2 + i % (MAX_PASSING_STATION_NUMBER - 1);
+            trainData(i, scheduler.passingStationNum, scheduler.stations, scheduler.duration, scheduler.price);
+            legacy.insert(scheduler.trainID, scheduler);
+        }
+    }
+    for (int round = 0; round < 2; round++) {
+        SchedulerManager manager("test_legacy");
+        for (int i = 0; i < 50; i++) {
+            checkTrain(manager, i, 2 + i % (MAX_PASSING_STATION_NUMBER - 1));
+        }
+        if (round == 0) {
+            addTrain(manager, 50, 3);
+        } else {
+            checkTrain(manager, 50, 3);
+        }
+    }
+    assert(countFiles("test_legacy", "_rewrite") == 0 && countFiles("test_legacy", "_records.") == 0);
+    destroySchedulerFiles("test_legacy");
+    cout << "✓ B+树中的定长调度信息被转换成记录文件" << endl;
+
+    // 版本1：记录全部用zigzag变长整数编码，站点记与前一站的差
+    destroySchedulerFiles("test_v1");
+    {
+        std::ofstream fout("test_v1_records", std::ios::out | std::ios::binary | std::ios::trunc);
+        char header[24] = {'T', 'S', 'S', 'C', 'H', 'E', 'D', '\0'};
+        header[8] = 1;
+        fout.write(header, sizeof(header));
+        long long offset = sizeof(header);
+        RawSlotTree tree("test_v1");
+        for (int i = 0; i < 50; i++) {
+            int stationNum = 2 + i % (MAX_PASSING_STATION_NUMBER - 1);
+            StationID stations[MAX_PASSING_STATION_NUMBER];
+            int duration[MAX_PASSING_STATION_NUMBER] = {}, price[MAX_PASSING_STATION_NUMBER] = {};
+            trainData(i, stationNum, stations, duration, price);
+            string name = "T" + to_string(i);
+            vector<char> record(2 + name.size() + VARINT_MAX_LENGTH * (2 + 3 * stationNum));
+            char *p = record.data();
+            *p++ = 1;
+            *p++ = static_cast<char>(name.size());
+            memcpy(p, name.data(), name.size());
+            p += name.size();
+            p += varintEncode(zigzagEncode(100 + i), p);
+            p += varintEncode(zigzagEncode(stationNum), p);
+            for (int j = 0; j < stationNum; j++) {
+                p += varintEncode(zigzagEncode(stations[j] - (j > 0 ? stations[j - 1] : 0)), p);
+            }
+            for (int j = 0; j + 1 < stationNum; j++) {
+                p += varintEncode(zigzagEncode(duration[j]), p);
+            }
+            for (int j = 0; j + 1 < stationNum; j++) {
+                p += varintEncode(zigzagEncode(price[j]), p);
+            }
+            int length = p - record.data();
+            fout.write(record.data(), length);
+            tree.insert(TrainID(name.c_str()), RawSlot{offset, length});
+            offset += length;
+        }
+    }
+    {
+        SchedulerManager manager("test_v1");
+        for (int i = 0; i < 50; i++) {
+            checkTrain(manager, i, 2 + i % (MAX_PASSING_STATION_NUMBER - 1));
+        }
+    }
+    {
+        std::ifstream fin("test_v1_records", std::ios::in | std::ios::binary);
+        char header[24];
+        fin.read(header, sizeof(header));
+        assert(header[8] == 2);
+    }
+    assert(countFiles("test_v1", "_rewrite") == 0 && countFiles("test_v1", "_records.") == 0);
+    destroySchedulerFiles("test_v1");
+    cout << "✓ 版本1的记录被转换成当前格式" << endl;
+
+    // 未知版本
+    destroySchedulerFiles("test_v9");
+    {
+        std::ofstream fout("test_v9_records", std::ios::out | std::ios::binary | std::ios::trunc);
+        char header[24] = {'T', 'S', 'S', 'C', 'H', 'E', 'D', '\0'};
+        header[8] = 9;
+        fout.write(header, sizeof(header));
+    }
+    expectRuntimeError([]() { SchedulerManager manager("test_v9"); });
+    destroySchedulerFiles("test_v9");
+    cout << "✓ 未知版本的记录文件被拒绝" << endl;
+}
+
+// 把名字以from开头的文件改成以to开头
+void renameFiles(const string &from, const string &to) {
+    vector<string> names;
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        string name = entry.path().filename().string();
+        if (name.rfind(from, 0) == 0) {
+            names.push_back(name);
+        }
+    }
+    for (const string &name : names) {
+        std::filesystem::rename(name, to + name.substr(from.size()));
+    }
+}
+
+// 在test_compact中放入T0到T99，删除奇数车次并覆盖T0，使析构时重写记录文件；
+// 返回前把重写后的数据复制到test_after开头的文件，再恢复重写前的数据
+void prepareCompaction() {
+    destroySchedulerFiles("test_compact");
+    destroySchedulerFiles("test_after");
+    {
+        SchedulerManager manager("test_compact");
+        for (int i = 0; i < 100; i++) {
+            addTrain(manager, i, 10);
+        }
+    }
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        string name = entry.path().filename().string();
+        if (name.rfind("test_compact_", 0) == 0) {
+            std::filesystem::copy_file(entry.path(), "test_before" + name.substr(12));
+        }
+    }
+    {
+        SchedulerManager manager("test_compact");
+        for (int i = 1; i < 100; i += 2) {
+            manager.removeScheduler(TrainID(("T" + to_string(i)).c_str()));
+        }
+        addTrain(manager, 0, 20);
+    }
+    assert(countFiles("test_compact", "_rewrite") == 0 && countFiles("test_compact", "_records.") == 0);
+    renameFiles("test_compact", "test_after");
+    renameFiles("test_before", "test_compact");
+}
+
+void checkCompacted(SchedulerManager &manager) {
+    checkTrain(manager, 0, 20);
+    for (int i = 1; i < 100; i++) {
+        if (i % 2 == 1) {
+            assert(!manager.existScheduler(TrainID(("T" + to_string(i)).c_str())));
+        } else {
+            checkTrain(manager, i, 10);
+        }
+    }
+}
+
+void testInterruptedCompaction() {
+    cout << "\n=== 测试中途退出的记录文件重写 ===" << endl;
+
+    // 新的记录文件和B+树写好，但还没有提交标记：丢弃新数据
+    prepareCompaction();
+    renameFiles("test_after", "test_compact_rewrite");
+    std::filesystem::rename("test_compact_rewrite_records", "test_compact_records.tmp");
+    {
+        SchedulerManager manager("test_compact");
+        for (int i = 0; i < 100; i++) {
+            checkTrain(manager, i, 10);
+        }
+    }
+    assert(countFiles("test_compact", "_rewrite") == 0 && countFiles("test_compact", "_records.") == 0);
+    cout << "✓ 没有提交标记时保留旧数据并删除新数据" << endl;
+
+    // 有提交标记，记录文件已替换，B+树只替换了一部分文件
+    destroySchedulerFiles("test_after");
+    prepareCompaction();
+    std::filesystem::rename("test_after_records", "test_compact_records");
+    vector<string> treeFiles;
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        string name = entry.path().filename().string();
+        if (name.rfind("test_after", 0) == 0) {
+            treeFiles.push_back(name.substr(10));
+        }
+    }
+    assert(treeFiles.size() > 1);
+    std::filesystem::rename("test_after" + treeFiles[0], "test_compact" + treeFiles[0]);
+    for (size_t i = 1; i < treeFiles.size(); i++) {
+        std::filesystem::rename("test_after" + treeFiles[i], "test_compact_rewrite" + treeFiles[i]);
+    }
+    std::ofstream("test_compact_rewrite.commit").close();
+    for (int round = 0; round < 2; round++) {
+        SchedulerManager manager("test_compact");
+        checkCompacted(manager);
+    }
+    assert(countFiles("test_compact", "_rewrite") == 0 && countFiles("test_compact", "_records.") == 0);
+    destroySchedulerFiles("test_compact");
+    destroySchedulerFiles("test_after");
+    cout << "✓ 有提交标记时完成剩下的改名" << endl;
+}
+
+int main() {
+    // 设置控制台编码
+    SetConsoleOutputCP(CP_UTF8);
+    SetConsoleCP(CP_UTF8);
+    std::system("chcp 65001 > nul");
+    std::system("cls");
+
+    cout << "开始 SchedulerManager 测试...\n" << endl;
+
+    try {
+        testRoundTrip();
+        testReferencesStation();
+        testTruncatedRecord();
+        testCorruptedSlot();
+        testUpgrade();
+        testInterruptedCompaction();
+
+        cout << "\n🎉 所有测试通过！" << endl;
+    } catch (const exception& e) {
+        cout << "❌ 测试失败: " << e.what() << endl;
+        return 1;
+    } catch (...) {
+        cout << "❌ 测试失败: 未知错误" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,518 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <random>
+#include <Windows.h>
+#include "TicketManager.h"
+
+using namespace trainsys;
+using namespace std;
+
+// 删除名为name的TicketManager留下的所有文件
+void destroyTicketFiles(const string &name) {
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        if (entry.path().filename().string().rfind(name + "_", 0) == 0) std::filesystem::remove(entry.path());
+    }
+}
+
+TrainScheduler makeTrain(const char *trainID, int stationNum, int seatNum) {
+    TrainScheduler scheduler;
+    scheduler.setTrainID(TrainID(trainID));
+    int price[MAX_PASSING_STATION_NUMBER] = {}, duration[MAX_PASSING_STATION_NUMBER] = {};
+    for (int i = 0; i < stationNum; i++) {
+        scheduler.addStation(10 + i);
+    }
+    scheduler.setPrice(price);
+    scheduler.setDuration(duration);
+    scheduler.setSeatNumber(seatNum);
+    return scheduler;
+}
+
+// 在随机的区间加和区间最小值上与逐段计算的结果比较
+template<class Cell>
+void checkSegmentTree() {
+    const int segments = MAX_PASSING_STATION_NUMBER - 1;
+    mt19937 rng(42);
+    int seats[MAX_PASSING_STATION_NUMBER];
+    for (int i = 0; i < segments; i++) {
+        seats[i] = 100 + static_cast<int>(rng() % 50);
+    }
+    SeatSegmentTree<Cell> tree;
+    tree.assign(seats, segments);
+    for (int round = 0; round < 5000; round++) {
+        int l = rng() % segments, r = l + 1 + rng() % (segments - l);
+        if (rng() % 2) {
+            int delta = static_cast<int>(rng() % 7) - 3;
+            tree.add(l, r, delta);
+            for (int i = l; i < r; i++) seats[i] += delta;
+        } else {
+            int expected = seats[l];
+            for (int i = l + 1; i < r; i++) expected = min(expected, seats[i]);
+            assert(tree.query(l, r) == expected);
+        }
+    }
+    SeatSegmentTree<int> copy;
+    copy.copyFrom(tree);
+    for (int i = 0; i < segments; i++) {
+        assert(copy.query(i, i + 1) == seats[i]);
+    }
+}
+
+void testSeatSegmentTree() {
+    cout << "=== 测试余票线段树 ===" << endl;
+
+    checkSegmentTree<int>();
+    checkSegmentTree<std::atomic<int>>();
+    cout << "✓ 普通和原子结点的线段树区间加、区间最小值与逐段计算一致" << endl;
+
+    StationID stations[4] = {5, 9, 2, 7};
+    int seats[3] = {10, 3, 8};
+    SeatInventory inventory(stations, 4, seats);
+    assert(inventory.query(0, 3) == 3 && inventory.query(2, 3) == 8);
+    inventory.add(0, 2, -3);
+    assert(inventory.query(0, 1) == 7 && inventory.query(1, 3) == 0 && inventory.query(2, 3) == 8);
+    cout << "✓ SeatInventory的区间预订只影响途经的区间\n" << endl;
+}
+
+void testConcurrentReserve() {
+    cout << "=== 测试多线程订票不超卖 ===" << endl;
+
+    destroyTicketFiles("test_ticket");
+    const int seatNum = 500, threadCount = 8;
+    TrainScheduler train = makeTrain("G100", 4, seatNum);
+    Date date(5, 1);
+    // sold[i]为第i段卖出的票数
+    atomic<int> sold[3];
+    for (int i = 0; i < 3; i++) {
+        sold[i] = 0;
+    }
+    {
+        TicketManager manager("test_ticket");
+        manager.releaseTicket(train, date);
+
+        // 各线程订不同的区间，区间互相重叠，一直订到买不到为止
+        vector<thread> buyers;
+        for (int t = 0; t < threadCount; t++) {
+            buyers.emplace_back([&, t]() {
+                int from = t % 3, to = from + 1 + t % (3 - from);
+                while (true) {
+                    int remaining = manager.reserve(train.getTrainID(), date, from, to, 1);
+                    if (remaining < 0) break;
+                    for (int i = from; i < to; i++) {
+                        sold[i]++;
+                    }
+                }
+            });
+        }
+        for (thread &buyer : buyers) {
+            buyer.join();
+        }
+        for (int i = 0; i < 3; i++) {
+            int remaining = manager.querySeat(train.getTrainID(), date, train.getStation(i), train.getStation(i + 1));
+            assert(remaining >= 0 && remaining + sold[i] == seatNum);
+        }
+        assert(manager.reserve(train.getTrainID(), date, 0, 3, 1) == -1);
+        cout << "✓ 每一段卖出的票数加余票等于座位数，没有超卖" << endl;
+
+        // 订票和退票交替进行，最后余票不变
+        int before = manager.querySeat(train.getTrainID(), date, train.getStation(1), train.getStation(2));
+        vector<thread> workers;
+        for (int t = 0; t < threadCount; t++) {
+            workers.emplace_back([&]() {
+                for (int i = 0; i < 2000; i++) {
+                    if (manager.release(train.getTrainID(), date, 1, 2, 1) >= 0) {
+                        while (manager.reserve(train.getTrainID(), date, 1, 2, 1) < 0) {
+                        }
+                    }
+                }
+            });
+        }
+        for (thread &worker : workers) {
+            worker.join();
+        }
+        assert(manager.querySeat(train.getTrainID(), date, train.getStation(1), train.getStation(2)) == before);
+        cout << "✓ 并发退票和订票后余票不变" << endl;
+    }
+
+    // 重新打开后写回的余票与内存中一致
+    {
+        TicketManager manager("test_ticket");
+        for (int i = 0; i < 3; i++) {
+            int remaining = manager.querySeat(train.getTrainID(), date, train.getStation(i), train.getStation(i + 1));
+            assert(remaining + sold[i] == seatNum);
+        }
+    }
+    destroyTicketFiles("test_ticket");
+    cout << "✓ 重新打开后余票正确" << endl;
+}
+
+void testSeatAssignment() {
+    cout << "\n=== 测试座位分配与余票一致 ===" << endl;
+
+    destroyTicketFiles("test_seat");
+    const int seatNum = 150, threadCount = 8;
+    TrainScheduler train = makeTrain("Z9", 4, seatNum);
+    Date date(3, 1);
+    // owner[seat]为占用第0段座位的线程，两个线程分到同一个座位时断言失败
+    vector<atomic<int> > owner(seatNum);
+    for (atomic<int> &o : owner) {
+        o = -1;
+    }
+    atomic<int> reserved(0), assigned(0);
+    {
+        TicketManager manager("test_seat");
+        manager.releaseTicket(train, date);
+        // 各线程轮流按座位订第0站到第2站、只按余票订第0站到第1站，直到两种都买不到为止
+        vector<thread> buyers;
+        for (int t = 0; t < threadCount; t++) {
+            buyers.emplace_back([&, t]() {
+                for (int i = t; ; i++) {
+                    if (i % 2 == 0) {
+                        int seat = manager.assignSeat(train.getTrainID(), date, train.getStation(0), train.getStation(2));
+                        if (seat >= 0) {
+                            int expected = -1;
+                            assert(owner[seat].compare_exchange_strong(expected, t));
+                            assigned++;
+                            continue;
+                        }
+                    } else if (manager.reserve(train.getTrainID(), date, 0, 1, 1) >= 0) {
+                        reserved++;
+                        continue;
+                    }
+                    if (manager.querySeat(train.getTrainID(), date, train.getStation(0), train.getStation(1)) == 0) break;
+                }
+            });
+        }
+        for (thread &buyer : buyers) {
+            buyer.join();
+        }
+        assert(assigned + reserved == seatNum);
+        assert(manager.querySeat(train.getTrainID(), date, train.getStation(0), train.getStation(1)) == 0);
+        assert(manager.countFreeSeats(train.getTrainID(), date, train.getStation(0), train.getStation(1)) == 0);
+        assert(manager.countFreeSeats(train.getTrainID(), date, train.getStation(2), train.getStation(3)) == seatNum);
+        // 按座位订出的票占用了第1段的座位，只按余票订出的票没有
+        assert(manager.countFreeSeats(train.getTrainID(), date, train.getStation(1), train.getStation(3)) ==
+               seatNum - assigned);
+        cout << "✓ 并发分配座位时没有重复的座位，空座数不超过余票" << endl;
+
+        // 退回按余票订出的票后，座位图上仍被占用的座位不会再分出去
+        assert(manager.release(train.getTrainID(), date, 0, 1, reserved) == reserved);
+        assert(manager.countFreeSeats(train.getTrainID(), date, train.getStation(0), train.getStation(1)) == reserved);
+        int seat = 0;
+        while (owner[seat] < 0) seat++;
+        assert(manager.releaseSeat(train.getTrainID(), date, train.getStation(0), train.getStation(2), seat));
+        assert(!manager.releaseSeat(train.getTrainID(), date, train.getStation(0), train.getStation(2), seat));
+        assert(manager.assignSeat(train.getTrainID(), date, train.getStation(0), train.getStation(1)) >= 0);
+        cout << "✓ 退票后座位图和余票同时恢复" << endl;
+
+        // storageLock被占用时，已在内存中的记录仍能订票、分配座位和查询
+        manager.queryDailyTickets(train.getTrainID(), date, [&](const TicketInfo &) {
+            future<void> booking = async(launch::async, [&]() {
+                assert(manager.reserve(train.getTrainID(), date, 2, 3, 1) == seatNum - 1);
+                assert(manager.assignSeat(train.getTrainID(), date, train.getStation(2), train.getStation(3)) >= 0);
+                assert(manager.countFreeSeats(train.getTrainID(), date, train.getStation(2), train.getStation(3)) ==
+                       seatNum - 2);
+            });
+            assert(booking.wait_for(chrono::seconds(10)) == future_status::ready);
+            booking.get();
+            return false;
+        });
+        cout << "✓ 订票路径不等待storageLock" << endl;
+    }
+
+    // 重新打开后座位图和余票都已写回
+    {
+        TicketManager manager("test_seat");
+        assert(manager.querySeat(train.getTrainID(), date, train.getStation(2), train.getStation(3)) == seatNum - 2);
+        assert(manager.countFreeSeats(train.getTrainID(), date, train.getStation(2), train.getStation(3)) == seatNum - 2);
+        // 退回的座位在第1段上空出，之后分配的座位只占第0段
+        assert(manager.countFreeSeats(train.getTrainID(), date, train.getStation(1), train.getStation(2)) ==
+               seatNum - assigned + 1);
+    }
+    destroyTicketFiles("test_seat");
+    cout << "✓ 重新打开后座位图和余票正确" << endl;
+}
+
+void testRecoverPartialRename() {
+    cout << "\n=== 测试改名中途崩溃后的恢复 ===" << endl;
+
+    destroyTicketFiles("test_recover");
+    destroyTicketFiles("test_source");
+    TrainScheduler first = makeTrain("K1", 3, 50), second = makeTrain("K2", 5, 80);
+    Date date(7, 1);
+    string partition = "test_recover_2026-" + string(date), staging = partition + ".staging";
+    {
+        TicketManager manager("test_recover", 2026, Date(1, 1));
+        manager.releaseTicket(first, date);
+    }
+    // 准备好合并后的临时分区：另建一个同时放了两个车次的分区，把它的文件改名成临时分区
+    {
+        TicketManager source("test_source", 2026, Date(1, 1));
+        source.releaseTicket(first, date);
+        source.releaseTicket(second, date);
+        assert(source.reserve(second.getTrainID(), date, 0, 4, 3) == 77);
+    }
+    string sourcePartition = "test_source_2026-" + string(date);
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        string name = entry.path().filename().string();
+        if (name.rfind(sourcePartition, 0) == 0) {
+            std::filesystem::rename(name, staging + name.substr(sourcePartition.size()));
+        }
+    }
+    // 提交清单已写完，车票树已改名，余票树和座位树尚未改名时崩溃
+    {
+        ofstream manifest("test_recover_release.commit");
+        manifest << 1 << '\n' << 2026 << ' ' << date.day << '\n';
+    }
+    for (const char *suffix : {"_leafFile", "_leafIndexFile", "_treeNodeFile"}) {
+        std::filesystem::rename(staging + suffix, partition + suffix);
+    }
+
+    {
+        TicketManager manager("test_recover", 2026, Date(1, 1));
+        assert(manager.queryDailyTickets(first.getTrainID(), date, [](const TicketInfo &) {}) == 2);
+        assert(manager.queryDailyTickets(second.getTrainID(), date, [](const TicketInfo &) {}) == 4);
+        assert(manager.querySeat(second.getTrainID(), date, second.getStation(0), second.getStation(4)) == 77);
+        assert(manager.querySeat(first.getTrainID(), date, first.getStation(0), first.getStation(2)) == 50);
+        // 只按余票订出的3张票没有占用座位图，但也要从能分配的座位中扣除
+        assert(manager.countFreeSeats(second.getTrainID(), date, second.getStation(0), second.getStation(1)) == 77);
+    }
+    assert(!std::filesystem::exists("test_recover_release.commit"));
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        assert(entry.path().filename().string().find(".staging") == string::npos);
+    }
+    destroyTicketFiles("test_recover");
+    destroyTicketFiles("test_source");
+    cout << "✓ 重新打开时改完剩下的树，已改名的车票树不会被删除" << endl;
+}
+
+// 把名为from的分区的所有文件改名为to开头，only不为空时只改名以from + only开头的文件
+void renamePartitionFiles(const string &from, const string &to, const string &only = "") {
+    vector<string> names;
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        string name = entry.path().filename().string();
+        if (name.rfind(from + only, 0) == 0) names.push_back(name);
+    }
+    for (const string &name : names) {
+        std::filesystem::rename(name, to + name.substr(from.size()));
+    }
+}
+
+void testYearPartitions() {
+    cout << "\n=== 测试分区的年份 ===" << endl;
+
+    destroyTicketFiles("test_year");
+    TrainScheduler train = makeTrain("T5", 3, 60);
+    Date spring(3, 1), autumn(8, 1);
+    // 售票窗口从2026-06-01开始，03-01属于2027年
+    {
+        TicketManager manager("test_year", 2026, Date(6, 1));
+        manager.releaseDate(&train, 1, spring);
+        manager.releaseTicket(train, autumn);
+        assert(manager.reserve(train.getTrainID(), spring, 0, 2, 5) == 55);
+    }
+    assert(std::filesystem::exists("test_year_2027-03-01_inventory_treeNodeFile"));
+    assert(std::filesystem::exists("test_year_2026-08-01_inventory_treeNodeFile"));
+    {
+        TicketManager manager("test_year", 2026, Date(7, 1));
+        assert(manager.querySeat(train.getTrainID(), spring, train.getStation(0), train.getStation(2)) == 55);
+    }
+    // 一年以后同样的日期属于新的一年，去年的车票不再可见
+    {
+        TicketManager manager("test_year", 2027, Date(6, 1));
+        assert(manager.querySeat(train.getTrainID(), spring, train.getStation(0), train.getStation(2)) == -1);
+        assert(manager.querySeat(train.getTrainID(), autumn, train.getStation(0), train.getStation(2)) == -1);
+        manager.releaseTicket(train, autumn);
+        assert(manager.reserve(train.getTrainID(), autumn, 0, 1, 1) == 59);
+    }
+    {
+        TicketManager manager("test_year", 2026, Date(6, 1));
+        assert(manager.querySeat(train.getTrainID(), autumn, train.getStation(0), train.getStation(1)) == 60);
+    }
+    destroyTicketFiles("test_year");
+    cout << "✓ 分区按售票窗口内的年份命名，不同年份的同一天互不影响" << endl;
+
+    // 版本1的分区：文件名不带年份，没有版本文件；还有一次按旧清单提交到一半的放票
+    TrainScheduler second = makeTrain("T6", 4, 40);
+    {
+        TicketManager manager("test_year", 2026, Date(1, 1));
+        manager.releaseTicket(train, autumn);
+        assert(manager.reserve(train.getTrainID(), autumn, 0, 2, 7) == 53);
+        manager.releaseTicket(train, spring);
+        manager.releaseTicket(second, spring);
+    }
+    renamePartitionFiles("test_year_2026-" + string(autumn), "test_year_" + string(autumn));
+    renamePartitionFiles("test_year_2026-" + string(spring), "test_year_" + string(spring) + ".staging");
+    std::filesystem::remove("test_year_version");
+    {
+        ofstream manifest("test_year_release.commit");
+        manifest << 1 << '\n' << spring.day << '\n';
+    }
+    // 升级时把08-01改名到2026年的途中崩溃：车票树已改名，余票树和座位树还在旧文件名下
+    for (const char *suffix : {"_leafFile", "_leafIndexFile", "_treeNodeFile"}) {
+        std::filesystem::rename("test_year_" + string(autumn) + suffix, "test_year_2026-" + string(autumn) + suffix);
+    }
+    {
+        TicketManager manager("test_year", 2026, Date(6, 1));
+        assert(manager.querySeat(train.getTrainID(), autumn, train.getStation(0), train.getStation(2)) == 53);
+        assert(manager.queryDailyTickets(train.getTrainID(), autumn, [](const TicketInfo &) {}) == 2);
+        assert(manager.querySeat(second.getTrainID(), spring, second.getStation(0), second.getStation(3)) == 40);
+        assert(manager.queryDailyTickets(second.getTrainID(), spring, [](const TicketInfo &) {}) == 3);
+    }
+    assert(std::filesystem::exists("test_year_2027-03-01_inventory_treeNodeFile"));
+    assert(!std::filesystem::exists("test_year_release.commit"));
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        string name = entry.path().filename().string();
+        if (name.rfind("test_year_", 0) != 0) continue;
+        assert(name.find(".staging") == string::npos);
+        assert(name == "test_year_version" || name.rfind("test_year_20", 0) == 0);
+    }
+    {
+        ifstream version("test_year_version");
+        int value = 0;
+        assert(version >> value && value == 2);
+    }
+    destroyTicketFiles("test_year");
+    cout << "✓ 旧版本的分区先完成未提交完的放票，再改名到对应的年份，改名中途崩溃后可以继续" << endl;
+}
+
+void testReleaseIntoExistingPartition() {
+    cout << "\n=== 测试向已有分区放票 ===" << endl;
+
+    destroyTicketFiles("test_merge");
+    destroyTicketFiles("test_extra");
+    TrainScheduler first = makeTrain("G1", 4, 90), second = makeTrain("G2", 3, 30), third = makeTrain("G3", 5, 20);
+    Date date(11, 11);
+    {
+        TicketManager manager("test_merge", 2026, Date(1, 1));
+        manager.releaseTicket(first, date);
+        assert(manager.reserve(first.getTrainID(), date, 0, 3, 10) == 80);
+        int seat = manager.assignSeat(first.getTrainID(), date, first.getStation(1), first.getStation(2));
+        assert(seat >= 0);
+        // 已放过票的车次跳过，原有车次的余票、座位和内存中尚未写回的修改都保留
+        TrainScheduler trains[2] = {first, second};
+        manager.releaseRange(trains, 2, date, date + 1);
+        assert(manager.querySeat(first.getTrainID(), date, first.getStation(0), first.getStation(3)) == 79);
+        assert(manager.countFreeSeats(first.getTrainID(), date, first.getStation(1), first.getStation(2)) == 79);
+        assert(manager.querySeat(second.getTrainID(), date, second.getStation(0), second.getStation(2)) == 30);
+        assert(manager.querySeat(first.getTrainID(), date + 1, first.getStation(0), first.getStation(3)) == 90);
+        assert(manager.reserve(second.getTrainID(), date, 0, 1, 4) == 26);
+    }
+    {
+        TicketManager manager("test_merge", 2026, Date(1, 1));
+        assert(manager.querySeat(first.getTrainID(), date, first.getStation(0), first.getStation(3)) == 79);
+        assert(manager.countFreeSeats(first.getTrainID(), date, first.getStation(1), first.getStation(2)) == 79);
+        assert(manager.querySeat(second.getTrainID(), date, second.getStation(0), second.getStation(1)) == 26);
+        assert(manager.queryDailyTickets(first.getTrainID(), date, [](const TicketInfo &) {}) == 3);
+        assert(manager.queryDailyTickets(second.getTrainID(), date, [](const TicketInfo &) {}) == 2);
+    }
+    cout << "✓ 临时分区只含新车次，提交时插入原分区，原有记录不受影响" << endl;
+
+    // 插入原分区之后、删除清单之前崩溃：清单和临时分区都还在，重新打开时再提交一次
+    string staging = "test_merge_2026-" + string(date) + ".staging";
+    {
+        TicketManager extra("test_extra", 2026, Date(1, 1));
+        extra.releaseTicket(second, date);
+        extra.releaseTicket(third, date);
+    }
+    renamePartitionFiles("test_extra_2026-" + string(date), staging);
+    {
+        ofstream manifest("test_merge_release.commit");
+        manifest << 1 << '\n' << 2026 << ' ' << date.day << '\n';
+    }
+    {
+        TicketManager manager("test_merge", 2026, Date(1, 1));
+        assert(manager.querySeat(second.getTrainID(), date, second.getStation(0), second.getStation(1)) == 26);
+        assert(manager.queryDailyTickets(second.getTrainID(), date, [](const TicketInfo &) {}) == 2);
+        assert(manager.querySeat(third.getTrainID(), date, third.getStation(0), third.getStation(4)) == 20);
+        assert(manager.queryDailyTickets(third.getTrainID(), date, [](const TicketInfo &) {}) == 4);
+        assert(manager.countFreeSeats(third.getTrainID(), date, third.getStation(0), third.getStation(4)) == 20);
+        assert(manager.querySeat(first.getTrainID(), date, first.getStation(0), first.getStation(3)) == 79);
+    }
+    assert(!std::filesystem::exists("test_merge_release.commit"));
+    assert(!std::filesystem::exists(staging + "_inventory_treeNodeFile"));
+    destroyTicketFiles("test_merge");
+    destroyTicketFiles("test_extra");
+    cout << "✓ 重新提交时已插入的记录跳过，已售出的车票不会被覆盖" << endl;
+}
+
+void testExpireWhileReserving() {
+    cout << "\n=== 测试订票期间停售 ===" << endl;
+
+    destroyTicketFiles("test_expire");
+    TrainScheduler train = makeTrain("D7", 3, 1000);
+    Date date(9, 1);
+    {
+        TicketManager manager("test_expire");
+        // 停售和重新放票反复进行，订票线程手中的记录被移出分片后要等它们用完才释放
+        atomic<bool> stop(false);
+        vector<thread> buyers;
+        for (int t = 0; t < 4; t++) {
+            buyers.emplace_back([&]() {
+                while (!stop) {
+                    if (manager.reserve(train.getTrainID(), date, 0, 2, 1) >= 0) {
+                        manager.release(train.getTrainID(), date, 0, 2, 1);
+                    }
+                    manager.querySeat(train.getTrainID(), date, train.getStation(0), train.getStation(1));
+                }
+            });
+        }
+        for (int round = 0; round < 50; round++) {
+            manager.releaseTicket(train, date);
+            this_thread::sleep_for(chrono::milliseconds(2));
+            if (round % 2 == 0) {
+                manager.expireDate(date);
+            } else {
+                manager.expireTicket(train.getTrainID(), date);
+            }
+        }
+        stop = true;
+        for (thread &buyer : buyers) {
+            buyer.join();
+        }
+        assert(manager.querySeat(train.getTrainID(), date, train.getStation(0), train.getStation(1)) == -1);
+
+        // 停售后重新放票，余票从座位数开始
+        manager.releaseTicket(train, date);
+        assert(manager.querySeat(train.getTrainID(), date, train.getStation(0), train.getStation(2)) == 1000);
+    }
+    destroyTicketFiles("test_expire");
+    cout << "✓ 停售时移出的记录在订票线程用完后释放，重新放票后余票正确" << endl;
+}
+
+int main() {
+    // 设置控制台编码
+    SetConsoleOutputCP(CP_UTF8);
+    SetConsoleCP(CP_UTF8);
+    std::system("chcp 65001 > nul");
+    std::system("cls");
+
+    cout << "开始 TicketManager 测试...\n" << endl;
+
+    try {
+        testSeatSegmentTree();
+        testConcurrentReserve();
+        testSeatAssignment();
+        testRecoverPartialRename();
+        testYearPartitions();
+        testReleaseIntoExistingPartition();
+        testExpireWhileReserving();
+
+        cout << "\n🎉 所有测试通过！" << endl;
+    } catch (const exception& e) {
+        cout << "❌ 测试失败: " << e.what() << endl;
+        return 1;
+    } catch (...) {
+        cout << "❌ 测试失败: 未知错误" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <filesystem>
+#include <Windows.h>
+#include "TripManager.h"
+#include "DataStructure/FormatVersion.h"
+
+using namespace trainsys;
+using namespace std;
+
+// 与版本1的TripInfo布局相同：日期按月、日两个int存放
+struct LegacyTrip {
+    TrainID trainID;
+    StationID departureStation;
+    StationID arrivalStation;
+    int ticketNumber;
+    int duration;
+    int price;
+    int mon;
+    int mday;
+
+    bool operator ==(const LegacyTrip &rhs) const {
+        return trainID == rhs.trainID && ticketNumber == rhs.ticketNumber && mon == rhs.mon && mday == rhs.mday;
+    }
+
+    bool operator <(const LegacyTrip &rhs) const {
+        if (trainID != rhs.trainID) return trainID < rhs.trainID;
+        if (mon != rhs.mon) return mon < rhs.mon;
+        if (mday != rhs.mday) return mday < rhs.mday;
+        return ticketNumber < rhs.ticketNumber;
+    }
+};
+
+// 删除名为name的TripManager留下的所有文件
+void destroyTripFiles(const string &name) {
+    for (const auto &entry : std::filesystem::directory_iterator(".")) {
+        if (entry.path().filename().string().rfind(name + "_", 0) == 0) std::filesystem::remove(entry.path());
+    }
+}
+
+// 用户u的第k条行程
+TripInfo expectedTrip(int u, int k) {
+    return TripInfo(TrainID(("G" + to_string(k)).c_str()), u, u + k + 1, k + 1, 30 * k, 100 * k,
+                    Date(1 + k % 12, 1 + (u + k) % 28));
+}
+
+void checkTrips(TripManager &manager, int users, int tripsPerUser) {
+    for (int u = 0; u < users; u++) {
+        seqList<TripInfo> trips = manager.queryTrip(u);
+        assert(trips.length() == tripsPerUser);
+        for (int k = 0; k < tripsPerUser; k++) {
+            bool found = false;
+            for (int i = 0; i < trips.length(); i++) {
+                found = found || trips.visit(i) == expectedTrip(u, k);
+            }
+            assert(found);
+        }
+    }
+}
+
+void testLegacyMigration() {
+    cout << "=== 测试旧格式行程文件的迁移 ===" << endl;
+
+    destroyTripFiles("test_trip");
+    {
+        BPlusTree<UserID, LegacyTrip> legacy("test_trip");
+        for (int u = 0; u < 50; u++) {
+            for (int k = 0; k < 5; k++) {
+                TripInfo trip = expectedTrip(u, k);
+                legacy.insert(u, LegacyTrip{trip.trainID, trip.departureStation, trip.arrivalStation, trip.ticketNumber,
+                                            trip.duration, trip.price, trip.date.mon(), trip.date.mday()});
+            }
+        }
+    }
+    {
+        TripManager manager("test_trip");
+        assert(readFormatVersion("test_trip") == 2);
+        assert((!BPlusTree<UserID, TripInfo>::exists("test_trip_migrated")));
+        checkTrips(manager, 50, 5);
+        manager.addTrip(50, expectedTrip(50, 0));
+    }
+    {
+        // 已是当前版本，不再转换
+        TripManager manager("test_trip");
+        checkTrips(manager, 50, 5);
+        assert(manager.queryTrip(50).length() == 1);
+    }
+    cout << "✓ 没有版本号的旧文件转换成当前格式，重新打开时不再转换" << endl;
+}
+
+void testInterruptedMigration() {
+    cout << "\n=== 测试中断的迁移 ===" << endl;
+
+    // 新树已写完、版本号已更新，改名前崩溃：重新打开时完成改名
+    destroyTripFiles("test_trip");
+    {
+        BPlusTree<UserID, TripInfo> upgraded("test_trip_migrated", true);
+        upgraded.insert(7, expectedTrip(7, 3));
+    }
+    {
+        BPlusTree<UserID, LegacyTrip> legacy("test_trip");
+        legacy.insert(1, LegacyTrip{});
+    }
+    writeFormatVersion("test_trip", 2);
+    {
+        TripManager manager("test_trip");
+        assert(manager.queryTrip(7).length() == 1 && manager.queryTrip(7).visit(0) == expectedTrip(7, 3));
+        assert(manager.queryTrip(1).length() == 0);
+    }
+    cout << "✓ 版本号已更新时完成改名" << endl;
+
+    // 版本号更新前崩溃：丢弃写了一半的新树，从旧文件重新转换
+    destroyTripFiles("test_trip");
+    {
+        BPlusTree<UserID, TripInfo> partial("test_trip_migrated", true);
+        partial.insert(9, expectedTrip(9, 0));
+    }
+    {
+        BPlusTree<UserID, LegacyTrip> legacy("test_trip");
+        TripInfo trip = expectedTrip(2, 1);
+        legacy.insert(2, LegacyTrip{trip.trainID, trip.departureStation, trip.arrivalStation, trip.ticketNumber,
+                                    trip.duration, trip.price, trip.date.mon(), trip.date.mday()});
+    }
+    {
+        TripManager manager("test_trip");
+        assert(manager.queryTrip(9).length() == 0);
+        assert(manager.queryTrip(2).length() == 1 && manager.queryTrip(2).visit(0) == expectedTrip(2, 1));
+    }
+    destroyTripFiles("test_trip");
+    cout << "✓ 版本号未更新时丢弃新树重新转换" << endl;
+}
+
+int main() {
+    // 设置控制台编码
+    SetConsoleOutputCP(CP_UTF8);
+    SetConsoleCP(CP_UTF8);
+    std::system("chcp 65001 > nul");
+    std::system("cls");
+
+    cout << "开始 TripManager 测试...\n" << endl;
+
+    try {
+        testLegacyMigration();
+        testInterruptedMigration();
+
+        cout << "\n🎉 所有测试通过！" << endl;
+    } catch (const exception& e) {
+        cout << "❌ 测试失败: " << e.what() << endl;
+        return 1;
+    } catch (...) {
+        cout << "❌ 测试失败: 未知错误" << endl;
+        return 1;
+    }
+
+    return 0;
+}